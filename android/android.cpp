@@ -18,10 +18,12 @@
 #include "zip/zip_file.h"
 #include "base/utils.h"
 #include "base/macros.h"
+#include "base/shared_cache.h"
 #include "common/bit.h"
 #include "common/elf.h"
 #include "android.h"
 #include "fdtrack/fdtrack.h"
+#include "heap/heap_graph.h"
 #include "unwindstack/Unwinder.h"
 #include "properties/property.h"
 #include "runtime/mirror/object.h"
@@ -73,6 +75,8 @@ std::unique_ptr<Android> Android::INSTANCE = nullptr;
 std::function<void ()> Android::RESETINI = nullptr;
 
 void Android::Init() {
+    SharedCache::Clean();
+    android::HeapGraph::Clean();
     INSTANCE = std::make_unique<Android>();
     INSTANCE->init();
 }
@@ -212,6 +216,8 @@ void Android::preLoadLater() {
     for (const auto& listener : mSdkListeners) {
         listener->execute(sdk);
     }
+    SharedCache::Clean();
+    android::HeapGraph::Clean();
     if (RESETINI) RESETINI();
 }
 
@@ -220,6 +226,8 @@ void Android::oatPreLoadLater() {
     for (const auto& listener : mOatListeners) {
         listener->execute(oat_header_.kOatVersion);
     }
+    SharedCache::Clean();
+    android::HeapGraph::Clean();
     if (RESETINI) RESETINI();
 }
 
@@ -289,14 +297,34 @@ void Android::ForeachInstanceField(art::mirror::Class& clazz, std::function<bool
     if (LIKELY(Sdk() >= W)) {
         uint32_t size = clazz.NumFields();
         if (!size) return;
+
+        // instance field index layout, shared with later fork child
+        uint32_t length = 0;
+        const uint32_t* layout = reinterpret_cast<const uint32_t*>(
+                SharedCache::Get(SharedCache::CLASS_INSTANCE_FIELDS, clazz.Ptr(), &length));
+        std::vector<uint32_t> indexes;
+        if (!layout) {
+            art::ArtField field(clazz.GetFields(), clazz);
+            int i = 0;
+            do {
+                if (!field.IsStatic())
+                    indexes.push_back(i);
+                field.MovePtr(SIZEOF(ArtField));
+                i++;
+            } while(i < size);
+            SharedCache::Put(SharedCache::CLASS_INSTANCE_FIELDS, clazz.Ptr(),
+                             indexes.data(), indexes.size() * sizeof(uint32_t));
+            layout = indexes.data();
+            length = indexes.size() * sizeof(uint32_t);
+        }
+
         art::ArtField field(clazz.GetFields(), clazz);
-        int i = 0;
-        do {
-            if (!field.IsStatic())
-                if (fn(field)) break;
-            field.MovePtr(SIZEOF(ArtField));
-            i++;
-        } while(i < size);
+        uint32_t current = 0;
+        for (int i = 0; i < length / sizeof(uint32_t); ++i) {
+            field.MovePtr(static_cast<int64_t>(layout[i] - current) * SIZEOF(ArtField));
+            current = layout[i];
+            if (fn(field)) break;
+        }
     } else {
         uint32_t size = clazz.NumInstanceFields();
         if (!size) return;
@@ -382,9 +410,6 @@ void Android::ForeachObjects(std::function<bool (art::mirror::Object& object)> f
 }
 
 void Android::ForeachObjects(std::function<bool (art::mirror::Object& object)> fn, int flag, bool check) {
-    art::Runtime& runtime = art::Runtime::Current();
-    art::gc::Heap& heap = runtime.GetHeap();
-
     auto walkfn = [&](art::gc::space::Space* space) {
         LOGD("Walk [%s] ...\n", space->GetName());
         try {
@@ -397,6 +422,12 @@ void Android::ForeachObjects(std::function<bool (art::mirror::Object& object)> f
             LOGW("Walk [%s] was interrupted!\n", space->GetName());
         }
     };
+    ForeachSpaces(walkfn, flag);
+}
+
+void Android::ForeachSpaces(std::function<void (art::gc::space::Space* space)> walkfn, int flag) {
+    art::Runtime& runtime = art::Runtime::Current();
+    art::gc::Heap& heap = runtime.GetHeap();
 
     for (const auto& space : heap.GetContinuousSpaces()) {
         if (space->IsImageSpace()) {
@@ -427,6 +458,57 @@ void Android::ForeachObjects(std::function<bool (art::mirror::Object& object)> f
     }
 }
 
+void Android::ObjectShard::Walk(std::function<bool (art::mirror::Object& object)> fn, bool check) {
+    try {
+        if (region >= 0) {
+            art::gc::space::RegionSpace* region_space = static_cast<art::gc::space::RegionSpace*>(space);
+            region_space->WalkRegion(fn, region, false, check);
+        } else {
+            space->Walk(fn, check);
+        }
+    } catch (InvalidAddressException& e) {
+        LOGW("Walk [%s] was interrupted!\n", space->GetName());
+    }
+}
+
+void Android::GetObjectShards(std::vector<ObjectShard>& shards, int flag) {
+    // prepare every lazy cache on this thread, workers only read.
+    auto shardfn = [&](art::gc::space::Space* space) {
+        LOGD("Walk [%s] ...\n", space->GetName());
+        try {
+            if (!space->IsVaildSpace()) {
+                LOGE("%s invalid space.\n", space->GetName());
+                return;
+            }
+
+            if (space->IsRegionSpace()) {
+                art::gc::space::RegionSpace* region_space = static_cast<art::gc::space::RegionSpace*>(space);
+                region_space->GetLiveBitmap();
+                uint64_t num_regions = region_space->num_regions();
+                for (uint64_t i = 0; i < num_regions; ++i)
+                    shards.push_back({space, static_cast<int64_t>(i)});
+            } else {
+                shards.push_back({space, -1});
+            }
+        } catch (InvalidAddressException& e) {
+            LOGW("Walk [%s] was interrupted!\n", space->GetName());
+        }
+    };
+    ForeachSpaces(shardfn, flag);
+}
+
+void Android::ParallelForeachObjects(std::function<bool (art::mirror::Object& object, int worker)> fn, int flag, bool check) {
+    std::vector<ObjectShard> shards;
+    GetObjectShards(shards, flag);
+
+    ThreadPool::ParallelFor(shards.size(), [&](uint64_t index, int worker) {
+        auto visitor = [&](art::mirror::Object& object) -> bool {
+            return fn(object, worker);
+        };
+        shards[index].Walk(visitor, check);
+    });
+}
+
 void Android::ForeachReferences(std::function<bool (art::mirror::Object& object)> fn) {
     ForeachReferences(fn, EACH_LOCAL_REFERENCES | EACH_GLOBAL_REFERENCES | EACH_WEAK_GLOBAL_REFERENCES);
 }
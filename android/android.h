@@ -18,6 +18,7 @@
 #define ANDROID_ANDROID_H_
 
 #include "api/core.h"
+#include "base/thread_pool.h"
 #include "runtime/oat.h"
 #include "runtime/runtime.h"
 #include "runtime/art_field.h"
@@ -180,6 +181,30 @@ public:
      */
     static void ForeachObjects(std::function<bool (art::mirror::Object& object)> fn);
     static void ForeachObjects(std::function<bool (art::mirror::Object& object)> fn, int flag, bool check);
+    static void ForeachSpaces(std::function<void (art::gc::space::Space* space)> fn, int flag);
+
+    struct ObjectShard {
+        art::gc::space::Space* space;
+        int64_t region;   // -1 walk the whole space
+        void Walk(std::function<bool (art::mirror::Object& object)> fn, bool check);
+    };
+    static void GetObjectShards(std::vector<ObjectShard>& shards, int flag);
+    /*
+     * region space shards by region, other spaces walk as one shard,
+     * fn may run on any worker at the same time, only touch state of
+     * its own worker and merge after return.
+     */
+    static void ParallelForeachObjects(std::function<bool (art::mirror::Object& object, int worker)> fn, int flag, bool check);
+    template <typename T>
+    static void ParallelForeachObjects(std::vector<T>& partials,
+                                       std::function<void (art::mirror::Object& object, T& partial)> fn, int flag, bool check) {
+        partials.resize(ThreadPool::GetThreads());
+        auto callback = [&](art::mirror::Object& object, int worker) -> bool {
+            fn(object, partials[worker]);
+            return false;
+        };
+        ParallelForeachObjects(callback, flag, check);
+    }
 
     static constexpr int EACH_LOCAL_REFERENCES = 1 << 0;
     static constexpr int EACH_GLOBAL_REFERENCES = 1 << 1;
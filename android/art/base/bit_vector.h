@@ -36,11 +36,11 @@ public:
         return 1 << (idx & 0x1f);
     }
 
-    static constexpr bool IsBitSet(api::MemoryRef& storage, uint32_t idx) {
+    static inline bool IsBitSet(api::MemoryRef& storage, uint32_t idx) {
         return (storage.value32Of(WordIndex(idx) * sizeof(uint32_t)) & BitMask(idx)) != 0;
     }
 
-    static constexpr uint32_t NumSetBits(api::MemoryRef& storage, uint32_t end) {
+    static inline uint32_t NumSetBits(api::MemoryRef& storage, uint32_t end) {
         uint32_t word_end = WordIndex(end);
         uint32_t partial_word_bits = end & 0x1f;
 
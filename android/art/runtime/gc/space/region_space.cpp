@@ -211,29 +211,33 @@ void RegionSpace::Walk(std::function<bool (mirror::Object& object)> fn, bool che
 }
 
 void RegionSpace::WalkInternal(std::function<bool (mirror::Object& object)> visitor, bool only, bool check) {
-    Region regions_(regions(), this);
     uint64_t num_regions_ = num_regions();
     for (int i = 0; i < num_regions_; ++i) {
-        Region r(regions_.Ptr() + i * SIZEOF(Region), regions_);
-        uint64_t pos = r.Begin();
-        uint64_t top = r.Top();
+        WalkRegion(visitor, i, only, check);
+    }
+}
 
-        if (r.IsFree() || (only && r.IsInToSpace()))
-            continue;
+void RegionSpace::WalkRegion(std::function<bool (mirror::Object& object)> visitor, uint64_t idx, bool only, bool check) {
+    Region regions_(regions(), this);
+    Region r(regions_.Ptr() + idx * SIZEOF(Region), regions_);
+    uint64_t pos = r.Begin();
+    uint64_t top = r.Top();
 
-        if (r.IsLarge()) {
-            mirror::Object object = r.Begin();
-            if (object.GetClass().Ptr() != 0x0) {
-                visitor(object);
-            }
-        } else if (r.IsLargeTail()) {
-            // Do nothing.
-        } else {
-            try {
-                WalkNonLargeRegion(visitor, r, check);
-            } catch (InvalidAddressException& e) {
-                LOGW("[0x%" PRIx64 "] Region:[0x%" PRIx64 ", 0x%" PRIx64 ") walkspace exception!\n", r.Ptr(), pos, top);
-            }
+    if (r.IsFree() || (only && r.IsInToSpace()))
+        return;
+
+    if (r.IsLarge()) {
+        mirror::Object object = r.Begin();
+        if (object.GetClass().Ptr() != 0x0) {
+            visitor(object);
+        }
+    } else if (r.IsLargeTail()) {
+        // Do nothing.
+    } else {
+        try {
+            WalkNonLargeRegion(visitor, r, check);
+        } catch (InvalidAddressException& e) {
+            LOGW("[0x%" PRIx64 "] Region:[0x%" PRIx64 ", 0x%" PRIx64 ") walkspace exception!\n", r.Ptr(), pos, top);
         }
     }
 }
@@ -80,6 +80,7 @@ public:
     bool IsDlMallocSpace() { return false; }
     void Walk(std::function<bool (mirror::Object& object)> fn, bool check);
     void WalkInternal(std::function<bool (mirror::Object& object)> fn, bool only, bool check);
+    void WalkRegion(std::function<bool (mirror::Object& object)> fn, uint64_t idx, bool only, bool check);
 
     enum class RegionType : uint8_t {
         kRegionTypeAll,              // All types.
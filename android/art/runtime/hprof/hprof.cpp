@@ -24,8 +24,15 @@
 #include "runtime/mirror/array.h"
 #include "runtime/runtime_globals.h"
 #include "android.h"
+#include "base/thread_pool.h"
 #include <vector>
+#include <memory>
 #include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
 #include <stdio.h>
 
 namespace art {
@@ -41,6 +48,9 @@ static constexpr uint32_t kHprofNullThread = 0;
 
 static constexpr size_t kMaxObjectsPerSegment = 128;
 static constexpr size_t kMaxBytesPerSegment = 4096;
+static constexpr size_t kFileBufferSize = 1024 * 1024;
+// serialized shards waiting for the writer, per worker thread.
+static constexpr uint64_t kShardsInFlightPerThread = 2;
 
 // The static field-name for the synthetic object generated to account for class static overhead.
 static constexpr const char* kClassOverheadName = "$classOverhead";
@@ -332,6 +342,12 @@ public:
         return errors_;
     }
 
+    // Append finished records, the current record must be ended.
+    void WriteRecords(const uint8_t* buffer, size_t length) {
+        if (length) HandleFlush(buffer, length);
+        sum_length_ += length;
+    }
+
 protected:
   void HandleFlush(const uint8_t* buffer, size_t length) override {
       if (!errors_) {
@@ -344,14 +360,61 @@ private:
   bool errors_;
 };
 
+// Keeps finished records of one object shard in memory.
+class SegmentEndianOutput final : public EndianOutputBuffered {
+public:
+    SegmentEndianOutput() : EndianOutputBuffered(kMaxBytesPerSegment) {}
+
+    std::vector<uint8_t>& Data() {
+        return data_;
+    }
+
+    // Offset of the next byte in Data() once the current record ends.
+    size_t Offset() const {
+        return data_.size() + length_;
+    }
+
+protected:
+    void HandleFlush(const uint8_t* buffer, size_t length) override {
+        data_.insert(data_.end(), buffer, buffer + length);
+    }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+/*
+ * Heap dump records of one object shard. String ids are not known
+ * until the shard is merged, so they are written as 0 and patched.
+ */
+struct HprofShard {
+    SegmentEndianOutput output;
+    std::vector<std::pair<size_t, uint32_t>> string_refs;  // (offset, index of strings)
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> string_index;
+    std::vector<mirror::Class> new_classes;                 // first seen order
+    std::unordered_map<mirror::Class, bool, mirror::Class::Hash> seen_classes;
+    size_t objects = 0;
+};
+
 #define __ output_->
 
 class Hprof {
 public:
-    Hprof(const char* output, bool visible, bool quick) : filename_(output)
-            ,visible_(visible), quick_(quick), first_(true) {}
+    Hprof(const char* output, bool visible, bool quick, bool stream) : filename_(output)
+            ,visible_(visible), quick_(quick), stream_(stream), first_(true) {}
 
     void Dump() {
+        if (stream_) {
+            LOGI("hprof: heap dump \"%s\" streaming...\n", filename_);
+            bool okay = DumpToFile(kMaxBytesPerSegment);
+            if (okay) {
+                LOGI("hprof: heap dump completed, scan objects (%lu).\n", total_objects_);
+                LOGI("hprof: saved [%s].\n", filename_);
+            }
+            return;
+        }
+
         LOGI("hprof: heap dump first prepare...\n");
         // First pass to measure the size of the dump.
         size_t max_length;
@@ -385,11 +448,19 @@ private:
         if (!fp)
             return false;
 
+        std::unique_ptr<char[]> fbuf = std::make_unique<char[]>(kFileBufferSize);
+        setvbuf(fp, fbuf.get(), _IOFBF, kFileBufferSize);
+
         FileEndianOutput file_output(fp, max_length);
         output_ = &file_output;
-        ProcessHeap(true);
+        if (stream_) {
+            ProcessStream();
+        } else {
+            ProcessHeap(true);
+        }
+        output_ = nullptr;
         fclose(fp);
-        return true;
+        return !file_output.Errors();
     }
 
     void ProcessHeap(bool header_first) {
@@ -404,6 +475,169 @@ private:
         }
     }
 
+    /*
+     * | header | HEAP_DUMP_SEGMENT ... | HEAP_DUMP_END | LOAD_CLASS ... | STACK_TRACE | STRING ... |
+     *
+     * Class and string ids are only known once every object has been seen,
+     * so the tables go after the heap dump and the heap is walked once.
+     */
+    void ProcessStream() {
+        current_heap_ = HPROF_HEAP_DEFAULT;
+        objects_in_segment_ = 0;
+        WriteFixedHeader();
+        if (ThreadPool::GetThreads() > 1 && !visible_) {
+            ProcessParallelBody();
+        } else {
+            ProcessBody();
+        }
+        ProcessTables(false);
+    }
+
+    /*
+     *             next shard                     merged
+     *                 |                            |
+     *  worker 0: --claim--> shard[n]   ...         v
+     *  worker 1: --claim--> shard[n+1] ... --> writer: shard[m], shard[m+1] ... -> file
+     *  worker 2: --claim--> shard[n+2] ...
+     *                  n < m + kShardsInFlightPerThread * threads
+     *
+     * Workers claim the next shard in order and serialize it into its own
+     * buffer, the writer thread appends shards in shard order and merges
+     * their strings and classes, so ids only depend on the heap and not on
+     * the scheduling. A worker waits while its shard is too far ahead of
+     * the writer, so only a bounded window of shards is held in memory.
+     */
+    void ProcessParallelBody() {
+        std::vector<Android::ObjectShard> shards;
+        Android::GetObjectShards(shards, Android::EACH_IMAGE_OBJECTS
+                                       | Android::EACH_ZYGOTE_OBJECTS
+                                       | Android::EACH_APP_OBJECTS
+                                       | Android::EACH_FAKE_OBJECTS);
+        // flush the fixed header.
+        output_->EndRecord();
+
+        int threads = ThreadPool::GetThreads();
+        std::vector<std::unique_ptr<Hprof>> workers;
+        for (int i = 0; i < threads; ++i)
+            workers.push_back(std::make_unique<Hprof>(filename_, false, quick_, true));
+
+        const uint64_t window = kShardsInFlightPerThread * threads;
+        std::vector<std::unique_ptr<HprofShard>> finished(shards.size());
+        std::atomic<uint64_t> next(0);
+        uint64_t merged = 0;
+        std::mutex lock;
+        std::condition_variable cond;
+        bool aborted = false;
+        std::exception_ptr error;
+
+        auto abort = [&]() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                aborted = true;
+            }
+            cond.notify_all();
+        };
+
+        std::thread writer([&]() {
+            for (size_t i = 0; i < finished.size(); ++i) {
+                std::unique_ptr<HprofShard> shard;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    cond.wait(guard, [&]() { return finished[i] || aborted; });
+                    if (!finished[i])
+                        return;
+                    shard = std::move(finished[i]);
+                }
+                try {
+                    MergeShard(*shard);
+                } catch (...) {
+                    error = std::current_exception();
+                    abort();
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    merged = i + 1;
+                }
+                cond.notify_all();
+            }
+        });
+
+        try {
+            ThreadPool::ParallelFor(threads, [&](uint64_t, int worker) {
+                try {
+                    for (;;) {
+                        uint64_t index = next.fetch_add(1);
+                        if (index >= shards.size())
+                            return;
+                        {
+                            std::unique_lock<std::mutex> guard(lock);
+                            cond.wait(guard, [&]() { return index < merged + window || aborted; });
+                            if (aborted)
+                                return;
+                        }
+                        std::unique_ptr<HprofShard> shard = std::make_unique<HprofShard>();
+                        workers[worker]->DumpShard(shards[index], *shard);
+                        {
+                            std::lock_guard<std::mutex> guard(lock);
+                            finished[index] = std::move(shard);
+                        }
+                        cond.notify_all();
+                    }
+                } catch (...) {
+                    // the writer would wait on this shard forever.
+                    abort();
+                    throw;
+                }
+            });
+        } catch (...) {
+            abort();
+            writer.join();
+            throw;
+        }
+        writer.join();
+        if (error)
+            std::rethrow_exception(error);
+
+        output_->StartNewRecord(HPROF_TAG_HEAP_DUMP_END, 0x0);
+        output_->EndRecord();
+    }
+
+    void DumpShard(Android::ObjectShard& object_shard, HprofShard& shard) {
+        output_ = &shard.output;
+        shard_ = &shard;
+        size_t total_objects = total_objects_;
+
+        StartNewHeapDumpSegment();
+        auto callback = [&](art::mirror::Object& object) -> bool {
+            return DumpHeapObject(object);
+        };
+        object_shard.Walk(callback, false);
+        output_->EndRecord();
+
+        shard.objects = total_objects_ - total_objects;
+        if (!shard.objects) shard.output.Data().clear();
+        output_ = nullptr;
+        shard_ = nullptr;
+    }
+
+    void MergeShard(HprofShard& shard) {
+        for (auto& klass : shard.new_classes)
+            LookupClassId(klass);
+
+        std::vector<uint8_t>& data = shard.output.Data();
+        for (const auto& ref : shard.string_refs) {
+            HprofStringId id = LookupStringId(shard.strings[ref.second]);
+            data[ref.first + 0] = static_cast<uint8_t>((id >> 24) & 0xFF);
+            data[ref.first + 1] = static_cast<uint8_t>((id >> 16) & 0xFF);
+            data[ref.first + 2] = static_cast<uint8_t>((id >> 8)  & 0xFF);
+            data[ref.first + 3] = static_cast<uint8_t>((id >> 0)  & 0xFF);
+        }
+
+        static_cast<FileEndianOutput*>(output_)->WriteRecords(data.data(), data.size());
+        total_objects_ += shard.objects;
+    }
+
     void ProcessBody() {
         // Walk the roots and the heap.
         output_->StartNewRecord(HPROF_TAG_HEAP_DUMP_SEGMENT, 0x0);
@@ -417,7 +651,10 @@ private:
 
     void ProcessHeader(bool string_first) {
         WriteFixedHeader();
+        ProcessTables(string_first);
+    }
 
+    void ProcessTables(bool string_first) {
         if (string_first) {
             WriteStringTable();
         }
@@ -480,13 +717,35 @@ private:
         return id;
     }
 
+    void AddStringRef(const std::string& string) {
+        if (!shard_) {
+            __ AddStringId(LookupStringId(string));
+            return;
+        }
+
+        uint32_t index;
+        auto it = shard_->string_index.find(string);
+        if (it != shard_->string_index.end()) {
+            index = it->second;
+        } else {
+            index = shard_->strings.size();
+            shard_->strings.push_back(string);
+            shard_->string_index.insert(std::pair<std::string, uint32_t>(string, index));
+        }
+        shard_->string_refs.push_back(std::pair<size_t, uint32_t>(shard_->output.Offset(), index));
+        __ AddStringId(0);
+    }
+
     HprofStringId LookupClassNameId(mirror::Class& c) {
         std::string desc = c.PrettyDescriptor();
         return LookupStringId(desc);
     }
 
     HprofClassObjectId LookupClassId(mirror::Class& c) {
-        if (c.Ptr()) {
+        if (c.Ptr() && shard_) {
+            if (shard_->seen_classes.insert(std::pair<mirror::Class, bool>(c, true)).second)
+                shard_->new_classes.push_back(c);
+        } else if (c.Ptr()) {
             auto it = classes_.find(c);
             if (it == classes_.end()) {
                 // first time to see this class
@@ -517,9 +776,11 @@ private:
     const char* filename_;
     bool visible_;
     bool quick_;
+    bool stream_;
     bool first_;
 
     EndianOutput* output_ = nullptr;
+    HprofShard* shard_ = nullptr;  // Shard being dumped by a parallel worker.
     HprofHeapId current_heap_ = HPROF_HEAP_DEFAULT;  // Which heap we're currently dumping.
     size_t objects_in_segment_ = 0;
 
@@ -552,7 +813,7 @@ bool Hprof::DumpHeapObject(mirror::Object& object) {
         if (thiz.IsRetired())
             return false;
     } else {
-        if (quick_ && first_)
+        if (quick_ && first_ && !stream_)
             return false;
     }
 
@@ -572,7 +833,7 @@ bool Hprof::DumpHeapObject(mirror::Object& object) {
     CheckHeapSegmentConstraints();
 
     if (heap_type != current_heap_) {
-        HprofStringId nameId;
+        const char* name;
 
         // This object is in a different heap than the current one.
         // Emit a HEAP_DUMP_INFO tag to change heaps.
@@ -581,20 +842,20 @@ bool Hprof::DumpHeapObject(mirror::Object& object) {
 
         switch (heap_type) {
             case HPROF_HEAP_APP:
-                nameId = LookupStringId("app");
+                name = "app";
                 break;
             case HPROF_HEAP_ZYGOTE:
-                nameId = LookupStringId("zygote");
+                name = "zygote";
                 break;
             case HPROF_HEAP_IMAGE:
-                nameId = LookupStringId("image");
+                name = "image";
                 break;
             default:
-                nameId = LookupStringId("<ILLEGAL>");
+                name = "<ILLEGAL>";
                 break;
         }
 
-        __ AddStringId(nameId);
+        AddStringRef(name);
         current_heap_ = heap_type;
     }
 
@@ -690,7 +951,7 @@ void Hprof::DumpHeapClass(mirror::Class& klass) {
     __ AddU2(static_cast<uint16_t>(static_fields_reported));
 
     if (java_heap_overhead_size != 0) {
-        __ AddStringId(LookupStringId(kClassOverheadName));
+        AddStringRef(kClassOverheadName);
         uint64_t overhead_fields = 0;
         if (java_heap_overhead_size > 4) {
             __ AddU1(Android::basic_object);
@@ -711,7 +972,7 @@ void Hprof::DumpHeapClass(mirror::Class& klass) {
                 case 3: {
                     __ AddU1(Android::basic_short);
                     __ AddU2(0);
-                    __ AddStringId(LookupStringId(std::string(kClassOverheadName) + "2"));
+                    AddStringRef(std::string(kClassOverheadName) + "2");
                     ++overhead_fields;
                 }
                 [[fallthrough]];
@@ -725,7 +986,7 @@ void Hprof::DumpHeapClass(mirror::Class& klass) {
     }
 
     auto static_field_writer = [&](ArtField& field, auto name_fn) -> bool {
-        __ AddStringId(LookupStringId(name_fn(field)));
+        AddStringRef(name_fn(field));
         Android::BasicType type = Android::SignatureToBasicTypeAndSize(field.GetTypeDescriptor(), nullptr, "B");
         __ AddU1(type);
         switch (type) {
@@ -786,7 +1047,7 @@ void Hprof::DumpHeapClass(mirror::Class& klass) {
     }
 
     auto klass_field_writer_inner = [&](art::ArtField& field) -> bool {
-        __ AddStringId(LookupStringId(field.GetName()));
+        AddStringRef(field.GetName());
         Android::BasicType type = Android::SignatureToBasicTypeAndSize(field.GetTypeDescriptor(), nullptr, "B");
         __ AddU1(type);
         return false;
@@ -795,10 +1056,10 @@ void Hprof::DumpHeapClass(mirror::Class& klass) {
 
     // Add native value character array for strings / byte array for compressed strings.
     if (klass.IsStringClass()) {
-        __ AddStringId(LookupStringId("value"));
+        AddStringRef("value");
         __ AddU1(Android::basic_object);
     } else if (add_internal_runtime_objects) {
-        __ AddStringId(LookupStringId("runtimeInternalObjects"));
+        AddStringRef("runtimeInternalObjects");
         __ AddU1(Android::basic_object);
     }
 }
@@ -944,8 +1205,8 @@ void Hprof::DumpFakeObjectArray(mirror::Object& object) {
     __ AddClassId(0);
 }
 
-void DumpHeap(const char* output, bool visible, bool quick) {
-    Hprof hprof(output, visible, quick);
+void DumpHeap(const char* output, bool visible, bool quick, bool stream) {
+    Hprof hprof(output, visible, quick, stream);
     hprof.Dump();
 }
 
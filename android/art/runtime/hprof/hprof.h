@@ -22,7 +22,7 @@
 namespace art {
 namespace hprof {
 
-void DumpHeap(const char* output, bool visible, bool quick);
+void DumpHeap(const char* output, bool visible, bool quick, bool stream);
 
 } // namespace hprof
 } // namespace art
@@ -76,6 +76,27 @@ std::map<uint32_t, DexRegisterInfo>& QuickFrame::GetVRegs() {
     return vregs_cache;
 }
 
+void QuickFrame::GetReferences(std::vector<uint32_t>& refs) {
+    if (GetMethod().IsNative() || !method_header.Ptr())
+        return;
+
+    if (!method_header.IsOptimized()) {
+        NterpGetFrameReferences(*this, refs);
+        return;
+    }
+
+    BitMemoryRegion mask;
+    uint32_t native_pc = static_cast<uint32_t>(frame_pc - method_header.GetCodeStart());
+    if (!method_header.NativePc2StackMask(native_pc, &mask))
+        return;
+    for (uint32_t slot = 0; slot < mask.size_in_bits(); ++slot) {
+        if (!mask.LoadBit(slot))
+            continue;
+        uint32_t value = value32Of(slot * kFrameSlotSize);
+        if (value) refs.push_back(value);
+    }
+}
+
 static uint32_t GetNumberOfReferenceArgsWithoutReceiver(ArtMethod& method) {
     uint32_t shorty_len;
     const char* shorty = method.GetShorty(&shorty_len);
@@ -44,6 +44,8 @@ public:
     uint64_t GetDexPcPtr();
     std::map<uint32_t, DexRegisterInfo>& GetVRegs();
     std::map<uint32_t, DexRegisterInfo>& GetVRegsCache() { return vregs_cache; }
+    // live references of the frame, as the gc sees them.
+    void GetReferences(std::vector<uint32_t>& refs);
     QuickMethodFrameInfo GetFrameInfo();
     static uint64_t ReturnPc2FramePc(uint64_t rpc);
     static std::string RegisterDesc(int idx, bool compat);
@@ -104,6 +104,15 @@ uint64_t ShadowFrame::GetDexPcPtr() {
     return dex_pc_ptr();
 }
 
+void ShadowFrame::GetReferences(std::vector<uint32_t>& refs) {
+    uint32_t num = number_of_vregs();
+    api::MemoryRef ref = vregs() + num * sizeof(uint32_t);
+    for (uint32_t i = 0; i < num; i++) {
+        uint32_t value = ref.value32Of(i * sizeof(uint32_t));
+        if (value) refs.push_back(value);
+    }
+}
+
 std::map<uint32_t, DexRegisterInfo>& ShadowFrame::GetVRegs() {
     if (!vregs_cache.size()) {
         api::MemoryRef ref = vregs();
@@ -20,6 +20,7 @@
 #include "api/memory_ref.h"
 #include "runtime/art_method.h"
 #include "runtime/oat/stack_map.h"
+#include <vector>
 
 struct ShadowFrame_OffsetTable {
     uint32_t link_;
@@ -60,6 +61,8 @@ public:
     inline ArtMethod GetMethod() { return method(); }
     uint64_t GetDexPcPtr();
     std::map<uint32_t, DexRegisterInfo>& GetVRegs();
+    // the reference array after vregs_, non-null entries only.
+    void GetReferences(std::vector<uint32_t>& refs);
 private:
     std::map<uint32_t, DexRegisterInfo> vregs_cache;
 };
@@ -45,6 +45,13 @@ public:
         }
         return empty_vregs;
     }
+    void GetReferences(std::vector<uint32_t>& refs) {
+        if (shadow_frame.Ptr()) {
+            shadow_frame.GetReferences(refs);
+        } else if (quick_frame.Ptr()) {
+            quick_frame.GetReferences(refs);
+        }
+    }
     void SetPrevQuickFrame(QuickFrame& qf) { prev_quick_frame = qf; }
 private:
     ArtMethod method;
@@ -19,7 +19,7 @@
 #include "android.h"
 #include "runtime/jit/jit_code_cache.h"
 #include "cxx/vector.h"
-#include <limits>
+#include <algorithm>
 
 struct JitCodeCache_OffsetTable __JitCodeCache_offset__;
 struct JniStubsMapPair_OffsetTable __JniStubsMapPair_offset__;
@@ -373,27 +373,45 @@ uint64_t ZygoteMap::GetCodeFor(ArtMethod& method, uint64_t pc) {
     return 0x0;
 }
 
-OatQuickMethodHeader JitCodeCache::LookupMethodCodeMap(uint64_t pc, ArtMethod& /*method*/) {
-    if (!GetMethodCodeMap().size()) {
-        return 0x0;
-    }
+/*
+ *  method_code_map_ (rb tree in core)         method_code_index
+ *  { code_ptr -> ArtMethod* } ...     -->   [start, size, method] sorted
+ *
+ * The core never changes, walk the tree once and binary search every pc
+ * after that instead of visiting all jit methods per frame.
+ */
+void JitCodeCache::BuildMethodCodeIndex() {
+    method_code_index_ready = true;
+    if (!GetMethodCodeMap().size())
+        return;
 
-    uint64_t code_ptr;
     uint32_t point_size = CoreApi::GetPointSize();
-    uint64_t nice = std::numeric_limits<uint64_t>::max();
     for (const auto& value : GetMethodCodeMap()) {
         api::MemoryRef ref = value;
-        uint64_t tmp_pc = ref.valueOf();
-        if (pc < tmp_pc)
-            continue;
-
-        if (pc - tmp_pc <= nice) {
-            nice = pc - tmp_pc;
-            code_ptr = tmp_pc;
-        }
+        MethodCode code = { ref.valueOf(), 0x0, ref.valueOf(point_size) };
+        try {
+            OatQuickMethodHeader method_header = OatQuickMethodHeader::FromCodePointer(code.code_start);
+            code.code_size = method_header.GetCodeSize();
+        } catch (InvalidAddressException& e) {}
+        method_code_index.push_back(code);
     }
+    std::sort(method_code_index.begin(), method_code_index.end());
+}
+
+OatQuickMethodHeader JitCodeCache::LookupMethodCodeMap(uint64_t pc, ArtMethod& /*method*/) {
+    if (!method_code_index_ready)
+        BuildMethodCodeIndex();
 
-    return OatQuickMethodHeader::FromCodePointer(code_ptr);
+    // closest code start at or below pc.
+    MethodCode key = { pc, 0x0, 0x0 };
+    auto it = std::upper_bound(method_code_index.begin(), method_code_index.end(), key);
+    if (it == method_code_index.begin())
+        return 0x0;
+    --it;
+
+    if (it->code_size && pc > it->code_start + it->code_size)
+        return 0x0;
+    return OatQuickMethodHeader::FromCodePointer(it->code_start);
 }
 
 OatQuickMethodHeader JitCodeCache::LookupMethodHeader(uint64_t pc, ArtMethod& method) {
@@ -22,6 +22,7 @@
 #include "runtime/jit/jit_memory_region.h"
 #include "base/mem_map.h"
 #include "cxx/map.h"
+#include <vector>
 
 struct JitCodeCache_OffsetTable {
     uint32_t code_map_;
@@ -113,6 +114,7 @@ public:
 
     OatQuickMethodHeader LookupMethodHeader(uint64_t pc, ArtMethod& method);
     OatQuickMethodHeader LookupMethodCodeMap(uint64_t pc, ArtMethod& method);
+    void BuildMethodCodeIndex();
     bool PrivateRegionContainsPc(uint64_t pc);
     bool ContainsPc(uint64_t pc);
     uint64_t GetJniStubCode(ArtMethod& method);
@@ -148,7 +150,21 @@ public:
         inline uint64_t first() { return VALUEOF(JniStubsMapPair, first); }
         inline uint64_t second() { return Ptr() + OFFSET(JniStubsMapPair, second); }
     };
+
+    struct MethodCode {
+        uint64_t code_start;
+        uint64_t code_size;   // 0 if the header can not be decoded
+        uint64_t method;
+
+        inline bool operator<(const MethodCode& other) const {
+            return code_start < other.code_start;
+        }
+    };
 private:
+    // method_code_map_ sorted by code start, built on first lookup.
+    std::vector<MethodCode> method_code_index;
+    bool method_code_index_ready = false;
+
     // quick memoryref cache
     MemMap code_map_cache = 0x0;
     MemMap exec_pages_cache = 0x0;
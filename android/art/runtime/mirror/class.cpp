@@ -19,6 +19,7 @@
 #include "common/bit.h"
 #include "api/core.h"
 #include "base/macros.h"
+#include "base/shared_cache.h"
 #include "runtime/mirror/class.h"
 #include "dex/descriptors_names.h"
 #include "base/length_prefixed_array.h"
@@ -443,9 +444,16 @@ uint64_t Class::GetPrimitiveTypeSizeShift() {
 }
 
 std::string Class::PrettyDescriptor() {
+    uint32_t length = 0;
+    const char* cache = reinterpret_cast<const char*>(
+            SharedCache::Get(SharedCache::CLASS_DESCRIPTOR, Ptr(), &length));
+    if (cache)
+        return std::string(cache, length);
+
     std::string temp;
     std::string result;
     AppendPrettyDescriptor(GetDescriptor(&temp), &result);
+    SharedCache::Put(SharedCache::CLASS_DESCRIPTOR, Ptr(), result.data(), result.length());
     return result;
 }
 
@@ -105,6 +105,27 @@ uint64_t NterpGetFrameDexPcPtr(QuickFrame& frame) {
     return dex_pc_ptr.valueOf();
 }
 
+// nterp keeps a reference only copy of the dex registers for the gc.
+void NterpGetFrameReferences(QuickFrame& frame, std::vector<uint32_t>& refs) {
+    ArtMethod& method = frame.GetMethod();
+    art::dex::CodeItem item = method.GetCodeItem();
+    const uint16_t num_regs = item.num_regs_;
+    const uint16_t out_regs = item.out_regs_;
+    uint32_t pointer_size = CoreApi::GetPointSize();
+
+    api::MemoryRef dex_refs_ptr(frame.Ptr() +
+                                pointer_size +
+                                RoundUp(out_regs * kVRegSize, pointer_size) +
+                                pointer_size +
+                                pointer_size,
+                                frame);
+
+    for (int i = 0; i < num_regs; ++i) {
+        uint32_t value = dex_refs_ptr.value32Of(i * sizeof(uint32_t));
+        if (value) refs.push_back(value);
+    }
+}
+
 void NterpGetFrameVRegs(QuickFrame& frame) {
     std::map<uint32_t, DexRegisterInfo>& vregs = frame.GetVRegsCache();
     ArtMethod& method = frame.GetMethod();
@@ -28,6 +28,7 @@ inline QuickMethodFrameInfo NterpFrameInfo(QuickFrame& frame) {
 }
 uint64_t NterpGetFrameDexPcPtr(QuickFrame& frame);
 void NterpGetFrameVRegs(QuickFrame& frame);
+void NterpGetFrameReferences(QuickFrame& frame, std::vector<uint32_t>& refs);
 
 } // namespace art
 
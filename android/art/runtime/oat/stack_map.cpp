@@ -736,6 +736,28 @@ void CodeInfo::NativePc2VRegs(uint32_t native_pc, std::map<uint32_t, DexRegister
     }
 }
 
+bool CodeInfo::NativePc2StackMask(uint32_t native_pc, BitMemoryRegion* mask) {
+    if (OatHeader::OatVersion() < 170)
+        return false;
+
+    StackMap& map = GetStackMap();
+    StackMask& stack_mask = GetStackMask();
+    if (!map.IsValid() || !stack_mask.IsValid())
+        return false;
+
+    for (int row = 0; row < map.NumRows(); row++) {
+        uint32_t packed_native_pc = map.Get(row, StackMap::kColNumPackedNativePc);
+        if (StackMap::UnpackNativePc(packed_native_pc) != native_pc)
+            continue;
+        uint32_t index = map.Get(row, StackMap::kColNumStackMaskIndex);
+        if (index == BitTable::kNoValue || index >= stack_mask.NumRows())
+            return false;
+        *mask = stack_mask.GetBitMemoryRegion(index, StackMask::kColNumMask);
+        return true;
+    }
+    return false;
+}
+
 void CodeInfo::NativePc2VRegsV0(uint32_t native_pc, std::map<uint32_t, DexRegisterInfo>& vregs) {
     if (region_.size() == 0)
         return;
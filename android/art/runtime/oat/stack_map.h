@@ -610,6 +610,8 @@ public:
 
     uint32_t NativePc2DexPc(uint32_t native_pc);
     void NativePc2VRegs(uint32_t native_pc, std::map<uint32_t, DexRegisterInfo>& vregs);
+    // bit i set, stack slot i holds a reference at this pc (170+).
+    bool NativePc2StackMask(uint32_t native_pc, BitMemoryRegion* mask);
     void NativeStackMaps(std::vector<GeneralStackMap>& maps);
     void ExtendNumRegister(ArtMethod& method);
 
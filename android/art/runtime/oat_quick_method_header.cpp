@@ -213,6 +213,11 @@ void OatQuickMethodHeader::NativePc2VRegs(uint32_t native_pc,
     code_info.NativePc2VRegs(native_pc, vregs);
 }
 
+bool OatQuickMethodHeader::NativePc2StackMask(uint32_t native_pc, BitMemoryRegion* mask) {
+    CodeInfo code_info = CodeInfo::Decode(GetOptimizedCodeInfoPtr());
+    return code_info.NativePc2StackMask(native_pc, mask);
+}
+
 void OatQuickMethodHeader::NativeStackMaps(std::vector<GeneralStackMap>& maps) {
     CodeInfo code_info = CodeInfo::Decode(GetOptimizedCodeInfoPtr());
     code_info.NativeStackMaps(maps);
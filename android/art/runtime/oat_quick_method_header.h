@@ -96,6 +96,7 @@ public:
     bool IsNterpMethodHeader();
     uint32_t NativePc2DexPc(uint32_t native_pc);
     void NativePc2VRegs(uint32_t native_pc, std::map<uint32_t, DexRegisterInfo>& vregs, art::ArtMethod& method);
+    bool NativePc2StackMask(uint32_t native_pc, BitMemoryRegion* mask);
     void NativeStackMaps(std::vector<GeneralStackMap>& maps);
     void Dump(const char* prefix);
 private:
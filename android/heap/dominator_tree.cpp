@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "heap/dominator_tree.h"
+#include <algorithm>
+
+namespace android {
+
+void DominatorTree::Build(int mask) {
+    uint32_t size = mGraph->size();
+    uint32_t entry = size;
+
+    std::vector<uint32_t> roots;
+    std::vector<bool> is_root(size, false);
+    for (const auto& root : mGraph->GetRoots()) {
+        if (!(root.kind & mask) || is_root[root.node])
+            continue;
+        is_root[root.node] = true;
+        roots.push_back(root.node);
+    }
+    std::sort(roots.begin(), roots.end());
+
+    auto successors = [&](uint32_t node) -> HeapGraph::Edges {
+        if (node == entry)
+            return { roots.data(), roots.data() + roots.size() };
+        return mGraph->Outbound(node);
+    };
+
+    // dfs numbers start at 1, 0 is unvisited and the "no ancestor" mark.
+    std::vector<uint32_t> dfn(size + 1, 0);
+    std::vector<uint32_t> vertex(size + 2, 0);
+    std::vector<uint32_t> parent(size + 2, 0);
+    uint32_t count = 0;
+    {
+        struct Frame {
+            uint32_t node;
+            uint32_t cursor;
+        };
+        std::vector<Frame> stack;
+        dfn[entry] = ++count;
+        vertex[count] = entry;
+        stack.push_back({entry, 0});
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            HeapGraph::Edges edges = successors(frame.node);
+            if (frame.cursor == edges.size()) {
+                stack.pop_back();
+                continue;
+            }
+            uint32_t next = edges.first[frame.cursor++];
+            if (dfn[next])
+                continue;
+            dfn[next] = ++count;
+            vertex[count] = next;
+            parent[count] = dfn[frame.node];
+            stack.push_back({next, 0});
+        }
+    }
+
+    // everything eval and link touch for one vertex sits on one line.
+    struct Slot {
+        uint32_t semi;
+        uint32_t label;
+        uint32_t ancestor;
+        uint32_t child;
+        uint32_t size;
+        uint32_t idom;
+    };
+    std::vector<Slot> slots(count + 1);
+    std::vector<uint32_t> bucket(count + 1, 0);
+    std::vector<uint32_t> chain(count + 1, 0);
+    for (uint32_t i = 0; i <= count; ++i)
+        slots[i] = { i, i, 0, 0, 1, 0 };
+    slots[0].size = 0;
+
+    std::vector<uint32_t> path;
+    auto compress = [&](uint32_t v) {
+        path.clear();
+        for (uint32_t u = v; slots[slots[u].ancestor].ancestor; u = slots[u].ancestor)
+            path.push_back(u);
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            Slot& x = slots[*it];
+            Slot& a = slots[x.ancestor];
+            if (slots[a.label].semi < slots[x.label].semi)
+                x.label = a.label;
+            x.ancestor = a.ancestor;
+        }
+    };
+    auto eval = [&](uint32_t v) -> uint32_t {
+        if (!slots[v].ancestor)
+            return slots[v].label;
+        compress(v);
+        uint32_t a = slots[slots[v].ancestor].label;
+        uint32_t l = slots[v].label;
+        return slots[a].semi >= slots[l].semi ? l : a;
+    };
+    // balanced linking keeps the forest shallow, see the paper's LINK.
+    auto link = [&](uint32_t v, uint32_t w) {
+        uint32_t s = w;
+        uint32_t wsemi = slots[slots[w].label].semi;
+        while (wsemi < slots[slots[slots[s].child].label].semi) {
+            uint32_t c = slots[s].child;
+            if (slots[s].size + slots[slots[c].child].size >= 2 * slots[c].size) {
+                slots[c].ancestor = s;
+                slots[s].child = slots[c].child;
+            } else {
+                slots[c].size = slots[s].size;
+                slots[s].ancestor = c;
+                s = c;
+            }
+        }
+        slots[s].label = slots[w].label;
+        slots[v].size += slots[w].size;
+        if (slots[v].size < 2 * slots[w].size)
+            std::swap(s, slots[v].child);
+        while (s) {
+            slots[s].ancestor = v;
+            s = slots[s].child;
+        }
+    };
+
+    for (uint32_t i = count; i >= 2; --i) {
+        uint32_t node = vertex[i];
+        uint32_t semi = i;
+        auto visit_pred = [&](uint32_t v) {
+            if (!v) return;
+            uint32_t u = eval(v);
+            if (slots[u].semi < semi)
+                semi = slots[u].semi;
+        };
+        for (uint32_t source : mGraph->Inbound(node))
+            visit_pred(dfn[source]);
+        if (is_root[node])
+            visit_pred(1);
+        slots[i].semi = semi;
+
+        chain[i] = bucket[semi];
+        bucket[semi] = i;
+        uint32_t p = parent[i];
+        link(p, i);
+        for (uint32_t v = bucket[p]; v; v = chain[v]) {
+            uint32_t u = eval(v);
+            slots[v].idom = slots[u].semi < slots[v].semi ? u : p;
+        }
+        bucket[p] = 0;
+    }
+    std::vector<uint32_t> idom(count + 1, 0);
+    for (uint32_t i = 2; i <= count; ++i) {
+        idom[i] = slots[i].idom;
+        if (idom[i] != slots[i].semi)
+            idom[i] = idom[idom[i]];
+    }
+
+    // release the work arrays before the per node results grow.
+    std::vector<Slot>().swap(slots);
+    std::vector<uint32_t>().swap(bucket);
+    std::vector<uint32_t>().swap(chain);
+    std::vector<uint32_t>().swap(parent);
+    std::vector<uint32_t>().swap(dfn);
+
+    // an idom always has a smaller dfs number, walk children first.
+    mIdoms.assign(size, HeapGraph::kInvalid);
+    mRetained.assign(size, 0);
+    mReachableSize = 0;
+    for (uint32_t i = count; i >= 2; --i) {
+        uint32_t node = vertex[i];
+        mRetained[node] += mGraph->GetSize(node);
+        mIdoms[node] = vertex[idom[i]];
+        if (idom[i] != 1) {
+            mRetained[vertex[idom[i]]] += mRetained[node];
+        } else {
+            mReachableSize += mRetained[node];
+        }
+    }
+    LOGD("Dominator tree %u reachable objects, 0x%" PRIx64 " bytes.\n", count - 1, mReachableSize);
+
+    BuildClassRetained();
+}
+
+void DominatorTree::BuildClassRetained() {
+    uint32_t size = mGraph->size();
+
+    // children by counting sort, the entry is slot size.
+    std::vector<uint32_t> offsets(size + 2, 0);
+    for (uint32_t node = 0; node < size; ++node) {
+        if (IsReachable(node))
+            offsets[mIdoms[node] + 1]++;
+    }
+    for (uint32_t node = 0; node <= size; ++node)
+        offsets[node + 1] += offsets[node];
+    std::vector<uint32_t> children(offsets[size + 1]);
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (uint32_t node = 0; node < size; ++node) {
+        if (IsReachable(node))
+            children[cursors[mIdoms[node]]++] = node;
+    }
+    std::vector<uint32_t>().swap(cursors);
+
+    // count a subtree once, at the outermost instance of each class.
+    std::unordered_map<uint32_t, uint32_t> active;
+    struct Frame {
+        uint32_t node;
+        uint32_t cursor;
+    };
+    std::vector<Frame> stack;
+    stack.push_back({size, offsets[size]});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.cursor == offsets[frame.node + 1]) {
+            if (frame.node != size)
+                active[mGraph->GetClass(frame.node)]--;
+            stack.pop_back();
+            continue;
+        }
+        uint32_t node = children[frame.cursor++];
+        uint32_t& depth = active[mGraph->GetClass(node)];
+        if (!depth)
+            mClassRetained[mGraph->GetClass(node)] += mRetained[node];
+        depth++;
+        stack.push_back({node, offsets[node]});
+    }
+}
+
+uint64_t DominatorTree::GetClassRetained(uint32_t klass) {
+    const auto& it = mClassRetained.find(klass);
+    return it != mClassRetained.end() ? it->second : 0;
+}
+
+} // namespace android
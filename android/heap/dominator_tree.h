@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HEAP_DOMINATOR_TREE_H_
+#define ANDROID_HEAP_DOMINATOR_TREE_H_
+
+#include "heap/heap_graph.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+
+/*
+ * Lengauer-Tarjan with balanced linking over the heap graph, a virtual
+ * node above every gc root is the entry. Work arrays are indexed by dfs
+ * number and freed after the build, no recursion.
+ *
+ *   retained(n) = shallow(n) + sum(retained(c)), idom(c) == n
+ *
+ * A class retains the subtrees of its instances that are not dominated
+ * by another instance of the same class, so nested instances count once.
+ * Like a quick approximation in MAT this is a lower bound, objects only
+ * kept by several instances together are not counted.
+ */
+class DominatorTree {
+public:
+    DominatorTree(HeapGraph* graph) : mGraph(graph) {}
+
+    void Build(int mask);
+    // mGraph->size() if only the gc roots dominate it.
+    uint32_t GetIdom(uint32_t node) { return mIdoms[node]; }
+    bool IsReachable(uint32_t node) { return mIdoms[node] != HeapGraph::kInvalid; }
+    uint64_t GetRetained(uint32_t node) { return mRetained[node]; }
+    uint64_t GetClassRetained(uint32_t klass);
+    uint64_t GetReachableSize() { return mReachableSize; }
+private:
+    void BuildClassRetained();
+
+    HeapGraph* mGraph;
+    std::vector<uint32_t> mIdoms;
+    std::vector<uint64_t> mRetained;
+    std::unordered_map<uint32_t, uint64_t> mClassRetained;
+    uint64_t mReachableSize = 0;
+};
+
+} // namespace android
+
+#endif  // ANDROID_HEAP_DOMINATOR_TREE_H_
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "android.h"
+#include "heap/heap_graph.h"
+#include "heap/dominator_tree.h"
+#include "common/exception.h"
+#include "base/thread_pool.h"
+#include "runtime/mirror/object.h"
+#include "runtime/mirror/class.h"
+#include "runtime/mirror/array.h"
+#include "runtime/art_field.h"
+#include "runtime/thread_list.h"
+#include "runtime/stack.h"
+#include "runtime/indirect_reference_table.h"
+#include <string.h>
+#include <algorithm>
+
+namespace android {
+
+std::unique_ptr<HeapGraph> HeapGraph::INSTANCE;
+
+static constexpr uint64_t kNodesPerChunk = 64 * 1024;
+
+HeapGraph* HeapGraph::Get() {
+    if (!INSTANCE) {
+        std::unique_ptr<HeapGraph> graph(new HeapGraph());
+        graph->Build();
+        LOGD("Heap graph %u objects, %" PRIu64 " references.\n", graph->size(), graph->edges());
+        INSTANCE = std::move(graph);
+    }
+    return INSTANCE.get();
+}
+
+void HeapGraph::Clean() {
+    INSTANCE.reset();
+}
+
+const char* HeapGraph::GetRootName(int kind) {
+    switch (kind) {
+        case ROOT_JNI_LOCAL: return "JNI Local";
+        case ROOT_JNI_GLOBAL: return "JNI Global";
+        case ROOT_JNI_WEAK_GLOBAL: return "JNI Weak Global";
+        case ROOT_THREAD_OBJECT: return "Thread Object";
+        case ROOT_JAVA_FRAME: return "Java Frame";
+        case ROOT_STICKY_CLASS: return "Sticky Class";
+    }
+    return "Unknown";
+}
+
+HeapGraph::HeapGraph() {}
+
+HeapGraph::~HeapGraph() {}
+
+DominatorTree* HeapGraph::GetDominatorTree() {
+    if (!mDominators) {
+        std::unique_ptr<DominatorTree> tree = std::make_unique<DominatorTree>(this);
+        tree->Build(ROOT_STRONG);
+        mDominators = std::move(tree);
+    }
+    return mDominators.get();
+}
+
+uint32_t HeapGraph::Find(uint32_t addr) {
+    const auto& it = std::lower_bound(mAddrs.begin(), mAddrs.end(), addr);
+    if (it == mAddrs.end() || *it != addr)
+        return kInvalid;
+    return it - mAddrs.begin();
+}
+
+void HeapGraph::Build() {
+    struct Node {
+        uint32_t addr;
+        uint32_t klass;
+        uint32_t size;
+        inline bool operator<(const Node& other) const { return addr < other.addr; }
+    };
+
+    std::vector<Android::ObjectShard> shards;
+    Android::GetObjectShards(shards, Android::EACH_APP_OBJECTS | Android::EACH_ZYGOTE_OBJECTS
+                                   | Android::EACH_IMAGE_OBJECTS | Android::EACH_FAKE_OBJECTS);
+
+    std::vector<std::vector<Node>> partials(shards.size());
+    ThreadPool::ParallelFor(shards.size(), [&](uint64_t index, int worker) {
+        std::vector<Node>& nodes = partials[index];
+        auto visitor = [&](art::mirror::Object& object) -> bool {
+            nodes.push_back({static_cast<uint32_t>(object.Ptr()),
+                             static_cast<uint32_t>(object.GetClass().Ptr()),
+                             static_cast<uint32_t>(object.SizeOf())});
+            return false;
+        };
+        shards[index].Walk(visitor, false);
+    });
+
+    std::vector<Node> nodes;
+    uint64_t total = 0;
+    for (const auto& partial : partials) total += partial.size();
+    nodes.reserve(total);
+    for (auto& partial : partials) {
+        nodes.insert(nodes.end(), partial.begin(), partial.end());
+        std::vector<Node>().swap(partial);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end(),
+            [](const Node& a, const Node& b) { return a.addr == b.addr; }), nodes.end());
+
+    mAddrs.resize(nodes.size());
+    mClasses.resize(nodes.size());
+    mSizes.resize(nodes.size());
+    for (uint64_t i = 0; i < nodes.size(); ++i) {
+        mAddrs[i] = nodes[i].addr;
+        mClasses[i] = nodes[i].klass;
+        mSizes[i] = nodes[i].size;
+    }
+    std::vector<Node>().swap(nodes);
+
+    BuildLayouts();
+
+    // out edges, chunks keep source order so the csr needs no sort.
+    uint32_t count = mAddrs.size();
+    uint64_t chunks = (count + kNodesPerChunk - 1) / kNodesPerChunk;
+    std::vector<std::vector<uint32_t>> targets(chunks);
+    mOutOffsets.assign(count + 1, 0);
+    ThreadPool::ParallelFor(chunks, [&](uint64_t index, int worker) {
+        uint32_t first = index * kNodesPerChunk;
+        uint32_t last = std::min<uint64_t>(first + kNodesPerChunk, count);
+        for (uint32_t node = first; node < last; ++node) {
+            uint64_t before = targets[index].size();
+            Visit(node, targets[index]);
+            mOutOffsets[node + 1] = targets[index].size() - before;
+        }
+    });
+
+    for (uint32_t node = 0; node < count; ++node)
+        mOutOffsets[node + 1] += mOutOffsets[node];
+    mOutTargets.resize(mOutOffsets[count]);
+    ThreadPool::ParallelFor(chunks, [&](uint64_t index, int worker) {
+        std::vector<uint32_t>& chunk = targets[index];
+        if (chunk.size())
+            memcpy(mOutTargets.data() + mOutOffsets[index * kNodesPerChunk],
+                   chunk.data(), chunk.size() * sizeof(uint32_t));
+        std::vector<uint32_t>().swap(chunk);
+    });
+
+    // in edges by counting sort, sources stay ascending per target.
+    mInOffsets.assign(count + 1, 0);
+    for (uint32_t target : mOutTargets)
+        mInOffsets[target + 1]++;
+    for (uint32_t node = 0; node < count; ++node)
+        mInOffsets[node + 1] += mInOffsets[node];
+    mInSources.resize(mOutTargets.size());
+    std::vector<uint64_t> cursors(mInOffsets.begin(), mInOffsets.end() - 1);
+    for (uint32_t node = 0; node < count; ++node) {
+        for (uint32_t target : Outbound(node))
+            mInSources[cursors[target]++] = node;
+    }
+
+    BuildRoots();
+}
+
+void HeapGraph::BuildRoots() {
+    auto add_root = [&](uint64_t addr, int kind) {
+        uint32_t node = Find(static_cast<uint32_t>(addr));
+        if (node != kInvalid)
+            mRoots.push_back({node, kind});
+    };
+
+    auto jni_fn = [&](art::mirror::Object& object, int type, uint64_t idx) -> bool {
+        switch (type & ((1 << Android::EACH_LOCAL_REFERENCES_BY_TID_SHIFT) - 1)) {
+            case art::IndirectRefKind::kLocal: add_root(object.Ptr(), ROOT_JNI_LOCAL); break;
+            case art::IndirectRefKind::kGlobal: add_root(object.Ptr(), ROOT_JNI_GLOBAL); break;
+            case art::IndirectRefKind::kWeakGlobal: add_root(object.Ptr(), ROOT_JNI_WEAK_GLOBAL); break;
+        }
+        return false;
+    };
+    try {
+        Android::ForeachReferences(jni_fn);
+    } catch (InvalidAddressException& e) {
+        LOGW("Walk jni references was interrupted!\n");
+    }
+
+    // only slots the gc treats as references, registers need a context we don't have.
+    if (art::Runtime::Current().Ptr()) {
+        art::ThreadList& thread_list = art::Runtime::Current().GetThreadList();
+        for (const auto& thread : thread_list.GetList()) {
+            try {
+                add_root(thread->GetTlsPtr().opeer(), ROOT_THREAD_OBJECT);
+                art::StackVisitor visitor(thread.get(), art::StackVisitor::StackWalkKind::kSkipInlinedFrames);
+                visitor.WalkStack();
+                std::vector<uint32_t> refs;
+                for (const auto& java_frame : visitor.GetJavaFrames()) {
+                    refs.clear();
+                    java_frame->GetReferences(refs);
+                    for (uint32_t ref : refs)
+                        add_root(ref, ROOT_JAVA_FRAME);
+                }
+            } catch (InvalidAddressException& e) {
+                LOGW("Walk [%d] java stack was interrupted!\n", thread->GetTid());
+            }
+        }
+    }
+}
+
+void HeapGraph::BuildLayouts() {
+    mLayoutKeys = mClasses;
+    std::sort(mLayoutKeys.begin(), mLayoutKeys.end());
+    mLayoutKeys.erase(std::unique(mLayoutKeys.begin(), mLayoutKeys.end()), mLayoutKeys.end());
+
+    auto reference_fn = [&](art::ArtField& field) -> bool {
+        if (Android::SignatureToBasicTypeAndSize(field.GetTypeDescriptor(), nullptr, "B") == Android::basic_object)
+            mSlots.push_back(field.offset());
+        return false;
+    };
+
+    std::vector<uint32_t> class_classes;
+    mLayouts.reserve(mLayoutKeys.size());
+    for (uint32_t klass : mLayoutKeys) {
+        Layout layout = { static_cast<uint32_t>(mSlots.size()), 0, false };
+        try {
+            art::mirror::Class clazz = klass;
+            art::mirror::Class current = clazz;
+            while (current.Ptr()) {
+                Android::ForeachInstanceField(current, reference_fn);
+                current = current.GetSuperClass();
+            }
+            layout.array = clazz.IsArrayClass() && !clazz.GetComponentType().IsPrimitive();
+            if (clazz.IsClassClass())
+                class_classes.push_back(klass);
+        } catch (InvalidAddressException& e) {
+            mSlots.resize(layout.begin);
+            layout.array = false;
+        }
+        layout.count = mSlots.size() - layout.begin;
+        mLayouts.push_back(layout);
+    }
+
+    // class objects are roots and also hold their own statics.
+    for (uint32_t node = 0; node < mAddrs.size(); ++node) {
+        if (std::find(class_classes.begin(), class_classes.end(), mClasses[node]) == class_classes.end())
+            continue;
+        mRoots.push_back({node, ROOT_STICKY_CLASS});
+        Layout layout = { static_cast<uint32_t>(mSlots.size()), 0, false };
+        try {
+            art::mirror::Class clazz = mAddrs[node];
+            Android::ForeachStaticField(clazz, reference_fn);
+        } catch (InvalidAddressException& e) {
+            mSlots.resize(layout.begin);
+        }
+        layout.count = mSlots.size() - layout.begin;
+        if (layout.count) {
+            mStaticKeys.push_back(mAddrs[node]);
+            mStatics.push_back(layout);
+        }
+    }
+}
+
+void HeapGraph::Visit(uint32_t node, std::vector<uint32_t>& targets) {
+    uint32_t addr = mAddrs[node];
+    try {
+        art::mirror::Object object = addr;
+        object.Real();  // throws if unreadable
+        // pointer and bound from one view, overlay, mmap or core.
+        LoadBlock* block = object.Block();
+        uint64_t offset = (addr & block->VabitsMask()) - block->vaddr();
+        uint64_t size = block->size(Block::OPT_READ_ALL);
+        if (offset >= size)
+            return;
+        const uint8_t* real = reinterpret_cast<const uint8_t*>(block->begin(Block::OPT_READ_ALL) + offset);
+        uint64_t limit = size - offset;
+
+        auto visit_slot = [&](uint64_t offset) {
+            if (offset + sizeof(uint32_t) > limit)
+                return;
+            uint32_t value;
+            memcpy(&value, real + offset, sizeof(value));
+            if (!value)
+                return;
+            uint32_t target = Find(value);
+            if (target != kInvalid)
+                targets.push_back(target);
+        };
+
+        auto visit_layout = [&](std::vector<uint32_t>& keys, std::vector<Layout>& layouts, uint32_t key) -> Layout* {
+            const auto& it = std::lower_bound(keys.begin(), keys.end(), key);
+            if (it == keys.end() || *it != key)
+                return nullptr;
+            Layout* layout = &layouts[it - keys.begin()];
+            for (uint32_t i = 0; i < layout->count; ++i)
+                visit_slot(mSlots[layout->begin + i]);
+            return layout;
+        };
+
+        Layout* layout = visit_layout(mLayoutKeys, mLayouts, mClasses[node]);
+        if (layout && layout->array) {
+            art::mirror::Array array = object;
+            int32_t length = array.GetLength();
+            uint64_t data = array.GetRawData(sizeof(uint32_t), 0) - addr;
+            for (int32_t i = 0; i < length && data + (i + 1) * sizeof(uint32_t) <= limit; ++i)
+                visit_slot(data + i * sizeof(uint32_t));
+        }
+        visit_layout(mStaticKeys, mStatics, addr);
+    } catch (InvalidAddressException& e) {
+        // keep edges found so far
+    }
+}
+
+} // namespace android
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HEAP_HEAP_GRAPH_H_
+#define ANDROID_HEAP_HEAP_GRAPH_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+namespace android {
+
+class DominatorTree;
+
+/*
+ * java heap reference graph, built once by two parallel walks.
+ *
+ *  nodes   : | addr0 | addr1 | addr2 | ... |   sorted, node id = index
+ *  out     : offsets[n + 1] -> | targets of n0 | targets of n1 | ... |
+ *  in      : offsets[n + 1] -> | sources of n0 | sources of n1 | ... |
+ *
+ * Edges only come from typed reference slots: instance reference fields
+ * of the whole class chain (shadow$_klass_ included), object array
+ * elements and static reference fields of class objects. Values that are
+ * not the start of a heap object are dropped.
+ *
+ * Gc roots are the jni references, thread peers, java stack slots and
+ * every class object, a node may be listed once per kind.
+ */
+class HeapGraph {
+public:
+    static constexpr uint32_t kInvalid = 0xFFFFFFFF;
+
+    static constexpr int ROOT_JNI_LOCAL = 1 << 0;
+    static constexpr int ROOT_JNI_GLOBAL = 1 << 1;
+    static constexpr int ROOT_JNI_WEAK_GLOBAL = 1 << 2;
+    static constexpr int ROOT_THREAD_OBJECT = 1 << 3;
+    static constexpr int ROOT_JAVA_FRAME = 1 << 4;
+    static constexpr int ROOT_STICKY_CLASS = 1 << 5;
+    static constexpr int ROOT_STRONG = ROOT_JNI_LOCAL | ROOT_JNI_GLOBAL | ROOT_THREAD_OBJECT
+                                     | ROOT_JAVA_FRAME | ROOT_STICKY_CLASS;
+
+    struct Root {
+        uint32_t node;
+        int kind;
+    };
+
+    struct Edges {
+        const uint32_t* first;
+        const uint32_t* last;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        uint32_t size() const { return last - first; }
+    };
+
+    static const char* GetRootName(int kind);
+
+    // build on first use, kept until the android env changes.
+    static HeapGraph* Get();
+    static void Clean();
+
+    HeapGraph();
+    ~HeapGraph();
+
+    uint32_t size() { return mAddrs.size(); }
+    uint64_t edges() { return mOutTargets.size(); }
+    uint32_t Find(uint32_t addr);
+    uint32_t GetAddress(uint32_t node) { return mAddrs[node]; }
+    uint32_t GetClass(uint32_t node) { return mClasses[node]; }
+    uint32_t GetSize(uint32_t node) { return mSizes[node]; }
+    std::vector<Root>& GetRoots() { return mRoots; }
+    // strong roots only, built on first use.
+    DominatorTree* GetDominatorTree();
+    Edges Outbound(uint32_t node) {
+        return { mOutTargets.data() + mOutOffsets[node], mOutTargets.data() + mOutOffsets[node + 1] };
+    }
+    Edges Inbound(uint32_t node) {
+        return { mInSources.data() + mInOffsets[node], mInSources.data() + mInOffsets[node + 1] };
+    }
+private:
+    struct Layout {
+        uint32_t begin;     // [begin, begin + count) of mSlots
+        uint32_t count;
+        bool array;         // object array, elements are references too
+    };
+
+    void Build();
+    void BuildLayouts();
+    void BuildRoots();
+    void Visit(uint32_t node, std::vector<uint32_t>& targets);
+
+    std::vector<uint32_t> mAddrs;
+    std::vector<uint32_t> mClasses;
+    std::vector<uint32_t> mSizes;
+    std::vector<uint64_t> mOutOffsets;
+    std::vector<uint32_t> mOutTargets;
+    std::vector<uint64_t> mInOffsets;
+    std::vector<uint32_t> mInSources;
+
+    // reference slot offsets per class, and per class object for statics.
+    std::vector<uint32_t> mSlots;
+    std::vector<Layout> mLayouts;
+    std::vector<uint32_t> mLayoutKeys;      // sorted class addr
+    std::vector<Layout> mStatics;
+    std::vector<uint32_t> mStaticKeys;      // sorted class object addr
+
+    std::vector<Root> mRoots;
+    std::unique_ptr<DominatorTree> mDominators;
+
+    static std::unique_ptr<HeapGraph> INSTANCE;
+};
+
+} // namespace android
+
+#endif  // ANDROID_HEAP_HEAP_GRAPH_H_
@@ -19,7 +19,7 @@
 #include "android.h"
 #include "api/core.h"
 #include "cxx/string.h"
-#include "llvm/Demangle/Demangle.h"
+#include "common/demangle_cache.h"
 
 struct FrameData_OffsetTable __FrameData_offset__;
 struct FrameData_SizeTable __FrameData_size__;
@@ -91,17 +91,7 @@ std::string UnwindStack::FrameData::GetMethod() {
             method = "(unknown)";
         return method;
     }
-    std::string symbol = name.c_str();
-    char* demangled_name = llvm::itaniumDemangle(symbol.c_str());
-    if (!demangled_name)
-        demangled_name = llvm::rustDemangle(symbol.c_str());
-    if (demangled_name) {
-        method = demangled_name;
-        std::free(demangled_name);
-    } else {
-        method = symbol;
-    }
-    return method;
+    return DemangleCache::Demangle(name.c_str());
 }
 
 uint64_t UnwindStack::FrameData::function_name() {
@@ -27,6 +27,7 @@
 #include "common/exception.h"
 #include "base/utils.h"
 #include "base/macros.h"
+#include "base/shared_cache.h"
 #include <linux/elf.h>
 #include <cstring>
 #include <iomanip>
@@ -291,11 +292,16 @@ ThreadApi* CoreApi::FindThread(int tid) {
 
 void CoreApi::addLinkMap(uint64_t map) {
     std::unique_ptr<LinkMap> linkmap = std::make_unique<LinkMap>(map);
+    mSymbols.Add(linkmap.get());
+    mLinkMapIndex.Invalidate();
     mLinkMap.push_back(std::move(linkmap));
 }
 
 void CoreApi::removeAllLinkMap() {
     removeAllBindMap();
+    mSymbols.clear();
+    mLinkMapIndex.Invalidate();
+    mDemangles.Clean();
     mLinkMap.clear();
 }
 
@@ -312,11 +318,19 @@ void CoreApi::Dump() {
 }
 
 void CoreApi::CleanCache() {
+    SharedCache::Clean();
     INSTANCE->removeAllLinkMap();
     api::MemoryRef& debug = INSTANCE->r_debug_ptr();
     debug = 0x0;
 }
 
+void CoreApi::CleanSymbols() {
+    if (!IsReady())
+        return;
+    INSTANCE->mSymbols.Invalidate();
+    INSTANCE->mDemangles.Clean();
+}
+
 void CoreApi::ForeachFile(std::function<bool (File *)> callback) {
     INSTANCE->foreachFile(callback);
 }
@@ -373,6 +387,38 @@ void CoreApi::ForeachAuxv(std::function<bool (Auxv *)> callback) {
     INSTANCE->foreachAuxv(callback);
 }
 
+/*
+ * LinkMap covering vaddr when its block has no bound handle, the first
+ * call after (re)loading link maps builds the interval index.
+ */
+LinkMap* CoreApi::FindLinkMap(uint64_t vaddr, LoadBlock* block) {
+    if (block && block->handle())
+        return block->handle();
+
+    LinkMapIndex& index = INSTANCE->mLinkMapIndex;
+    if (!index.IsReady()) {
+        std::vector<LinkMap*> maps;
+        auto callback = [&](LinkMap* map) -> bool {
+            maps.push_back(map);
+            return false;
+        };
+        INSTANCE->foreachLinkMap(callback);
+        index.Build(maps);
+    }
+
+    std::string filename;
+    if (block) filename = block->filename();
+    return index.Find(vaddr & GetVabitsMask(), filename);
+}
+
+/*
+ * Demangled name of the symbol at offset of map, views the shared cache
+ * until symbols change. An empty view leaves the name in storage.
+ */
+std::string_view CoreApi::Demangle(LinkMap* map, uint64_t offset, const char* symbol, std::string& storage) {
+    return INSTANCE->mDemangles.Find(map, offset, symbol, storage);
+}
+
 void CoreApi::ForeachLinkMap(std::function<bool (LinkMap *)> callback) {
     INSTANCE->foreachLinkMap(callback);
 }
@@ -397,6 +443,8 @@ void CoreApi::ExecFile(const char* path) {
         }
         if (filepath.length() > 0) {
             INSTANCE->exec(phdr, filepath.c_str());
+            INSTANCE->mLinkMapIndex.Invalidate();
+            CleanSymbols();
         }
     }
 }
@@ -430,6 +478,7 @@ void CoreApi::SysRoot(const char* path) {
         return false;
     };
     INSTANCE->foreachLinkMap(callback);
+    INSTANCE->mLinkMapIndex.Invalidate();
 }
 
 void CoreApi::Write(uint64_t vaddr, void *buf, uint64_t size) {
@@ -437,6 +486,8 @@ void CoreApi::Write(uint64_t vaddr, void *buf, uint64_t size) {
     if (!block)
         throw InvalidAddressException(vaddr);
     block->setOverlay(vaddr, buf, size);
+    INSTANCE->mWriteGeneration++;
+    SharedCache::Clean();
 }
 
 bool CoreApi::Read(uint64_t vaddr, uint64_t size, uint8_t* buf, int opt) {
@@ -460,17 +511,14 @@ void CoreApi::ForeachLoadBlock(std::function<bool (LoadBlock *)> callback, bool
 }
 
 uint64_t CoreApi::DlSym(const char* symbol) {
-    uint64_t value = 0x0;
-    auto callback = [&](LinkMap* map) -> bool {
-        value = map->DlSym(symbol);
-        if (value) {
-            value += map->l_addr();
-            return true;
-        }
-        return false;
-    };
+    // first call loads the link maps.
+    auto callback = [](LinkMap* map) -> bool { return true; };
     INSTANCE->foreachLinkMap(callback);
-    return value;
+
+    uint64_t offset = 0x0;
+    LinkMap* map = INSTANCE->mSymbols.Find(symbol, &offset);
+    if (map) return map->l_addr() + offset;
+    return 0x0;
 }
 
 uint64_t CoreApi::DlSym(const char* path, const char* symbol) {
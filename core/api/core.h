@@ -22,6 +22,9 @@
 #include "common/load_block.h"
 #include "common/note_block.h"
 #include "common/link_map.h"
+#include "common/symbol_interner.h"
+#include "common/link_map_index.h"
+#include "common/demangle_cache.h"
 #include "common/file.h"
 #include "common/exception.h"
 #include <stdint.h>
@@ -126,17 +129,22 @@ public:
     static void Init();
     static void Dump();
     static void CleanCache();
+    static void CleanSymbols();
     static void ForeachFile(std::function<bool (File *)> callback);
     static void ForeachAuxv(std::function<bool (Auxv *)> callback);
     static void ForeachLinkMap(std::function<bool (LinkMap *)> callback);
     static File* FindFile(uint64_t vaddr);
     static LinkMap* FindLinkMap(const char* path);
+    static LinkMap* FindLinkMap(uint64_t vaddr, LoadBlock* block);
+    static std::string_view Demangle(LinkMap* map, uint64_t offset, const char* symbol, std::string& storage);
     static void ExecFile(const char* file);
     static void SysRoot(const char* dir);
     static void Write(uint64_t vaddr, uint64_t value) {
         Write(vaddr, &value, 8);
     }
     static void Write(uint64_t vaddr, void *buf, uint64_t size);
+    // bumped by every Write, anything derived from memory contents compares it.
+    static uint64_t GetWriteGeneration() { return INSTANCE->mWriteGeneration; }
     static bool Read(uint64_t vaddr, uint64_t size, uint8_t* buf) {
         return Read(vaddr, size, buf, OPT_READ_ALL);
     }
@@ -273,8 +281,12 @@ private:
     std::vector<std::shared_ptr<LoadBlock>> mQuickLoad;
     std::vector<std::unique_ptr<NoteBlock>> mNote;
     std::vector<std::unique_ptr<LinkMap>> mLinkMap;
+    SymbolInterner mSymbols;
+    LinkMapIndex mLinkMapIndex;
+    DemangleCache mDemangles;
     static std::function<void (LinkMap *)> SYSROOT_CALLBACK;
     bool mRemote = false;
+    uint64_t mWriteGeneration = 0;
 };
 
 #endif // CORE_API_CORE_H_
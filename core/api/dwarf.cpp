@@ -17,8 +17,10 @@
 #include "logger/log.h"
 #include "api/dwarf.h"
 #include "base/memory_map.h"
+#include "base/thread_pool.h"
 #include <linux/elf.h>
 #include <string.h>
+#include <algorithm>
 #include <stack>
 #ifdef __ZSTD__
 #include <zstd.h>
@@ -184,7 +186,7 @@ bool DwarfLoader::ParseExprloc(const uint8_t* data, uint64_t size, uint64_t* out
 const uint8_t* DwarfLoader::ReadAttrValue(const uint8_t* ptr, const uint8_t* end,
                                            uint32_t form, uint32_t addr_size,
                                            bool dwarf64, uint64_t str_offsets_base,
-                                           uint64_t* out_value, std::string* out_str) {
+                                           uint64_t* out_value, std::string* out_str) const {
     if (!ptr || ptr >= end) return nullptr;
 
     auto read_u8  = [&]() -> uint8_t  { uint8_t  v = *ptr; ptr += 1; return v; };
@@ -506,29 +508,110 @@ void DwarfLoader::ParseAbbrevSection() {
          (unsigned long)debug_abbrev_size_, abbrev_map_.size());
 }
 
-const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_end,
-                                          uint32_t addr_size, bool dwarf64,
-                                          const AbbrevTable& abbrev_table,
-                                          const std::string& ns_prefix,
-                                          uint64_t str_offsets_base,
-                                          uint64_t cu_base_offset) {
-    // Use index instead of pointer to avoid dangling refs after structs_ reallocation.
+const uint8_t* DwarfLoader::ReadDIE(const uint8_t* ptr, const UnitInfo& unit,
+                                    bool names, DieInfo* die) const {
+    const uint8_t* cu_end = debug_info_data_ + unit.end;
+    die->code = ReadULEB128(&ptr, cu_end);
+    if (die->code == 0) return ptr; // null DIE
+
+    auto it = unit.abbrev->find((uint32_t)die->code);
+    if (it == unit.abbrev->end()) {
+        // Corrupted or unknown abbrev code — stop parsing this CU
+        LOGD("unknown abbrev code %lu, stopping CU parse\n", (unsigned long)die->code);
+        return nullptr;
+    }
+
+    const AbbrevEntry& entry = it->second;
+    die->tag = entry.tag;
+    die->has_children = entry.has_children;
+    die->name.clear();
+    die->member_loc = 0;  die->has_member_loc = false;
+    die->byte_size  = 0;  die->has_byte_size  = false;
+    die->type_ref   = 0;
+
+    // the index scan only needs names that open a scope or a struct.
+    bool want_name = names || entry.tag == DW_TAG_namespace
+                           || entry.tag == DW_TAG_structure_type
+                           || entry.tag == DW_TAG_class_type;
+    uint64_t type_ref = 0;
+    uint32_t type_ref_form = 0;
+
+    for (const AttrSpec& attr : entry.attrs) {
+        uint64_t v = 0;
+        bool want = false;
+        switch (attr.name) {
+        case DW_AT_data_member_location:
+        case DW_AT_byte_size:
+        case DW_AT_type:
+            want = true;
+            break;
+        default:
+            break;
+        }
+
+        if (attr.form == DW_FORM_implicit_const) {
+            v = (uint64_t)attr.implicit_const;
+            // no bytes consumed from .debug_info
+        } else {
+            std::string* s = (attr.name == DW_AT_name && want_name) ? &die->name : nullptr;
+            const uint8_t* next = ReadAttrValue(ptr, cu_end, attr.form,
+                                                unit.addr_size, unit.dwarf64,
+                                                unit.str_offsets_base,
+                                                want ? &v : nullptr, s);
+            if (!next) {
+                // parse error; skip to end of CU
+                return nullptr;
+            }
+            ptr = next;
+        }
+
+        switch (attr.name) {
+        case DW_AT_data_member_location:
+            die->member_loc = v;
+            die->has_member_loc = true;
+            break;
+        case DW_AT_byte_size:
+            die->byte_size = v;
+            die->has_byte_size = true;
+            break;
+        case DW_AT_type:
+            type_ref = v;
+            type_ref_form = attr.form;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Convert CU-relative type ref to absolute .debug_info offset,
+    // type unit signatures are not offsets at all.
+    if (type_ref_form && type_ref_form != DW_FORM_ref_sig8)
+        die->type_ref = IsRelRef(type_ref_form) ? unit.offset + type_ref : type_ref;
+    return ptr;
+}
+
+const uint8_t* DwarfLoader::ParseDIETree(const UnitInfo& unit, ParsedUnit* out) const {
+    // Use index instead of pointer to avoid dangling refs after structs reallocation.
     static constexpr int kNoStruct = -1;
 
     struct StackFrame {
         std::string ns_prefix;
-        int struct_idx; // index into structs_, or kNoStruct
+        int struct_idx; // index into out->structs, or kNoStruct
     };
 
     std::stack<StackFrame> stk;
-    std::string cur_ns = ns_prefix;
+    std::string cur_ns;
     int cur_struct_idx = kNoStruct;
+    const uint8_t* ptr = debug_info_data_ + unit.die;
+    const uint8_t* cu_end = debug_info_data_ + unit.end;
+    DieInfo die;
 
     while (ptr < cu_end) {
         uint64_t die_abs_offset = (uint64_t)(ptr - debug_info_data_);
-        uint64_t code = ReadULEB128(&ptr, cu_end);
+        ptr = ReadDIE(ptr, unit, true, &die);
+        if (!ptr) return nullptr;
 
-        if (code == 0) {
+        if (die.code == 0) {
             // Null DIE: pop scope
             if (stk.empty()) break;
             cur_ns         = stk.top().ns_prefix;
@@ -537,68 +620,13 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
             continue;
         }
 
-        auto it = abbrev_table.find((uint32_t)code);
-        if (it == abbrev_table.end()) {
-            // Corrupted or unknown abbrev code — stop parsing this CU
-            LOGD("unknown abbrev code %lu, stopping CU parse\n", (unsigned long)code);
-            return nullptr;
-        }
-
-        const AbbrevEntry& entry = it->second;
-
-        // Read all attributes
-        std::string die_name;
-        uint64_t member_loc  = 0;  bool has_member_loc = false;
-        uint64_t byte_sz     = 0;  bool has_byte_sz    = false;
-        uint64_t type_ref    = 0;  uint32_t type_ref_form = 0;
-
-        for (const AttrSpec& attr : entry.attrs) {
-            uint64_t v = 0;
-            std::string s;
-
-            if (attr.form == DW_FORM_implicit_const) {
-                v = (uint64_t)attr.implicit_const;
-                // no bytes consumed from .debug_info
-            } else {
-                const uint8_t* next = ReadAttrValue(ptr, cu_end, attr.form,
-                                                     addr_size, dwarf64,
-                                                     str_offsets_base, &v, &s);
-                if (!next) {
-                    // parse error; skip to end of CU
-                    return nullptr;
-                }
-                ptr = next;
-            }
-
-            switch (attr.name) {
-            case DW_AT_name:
-                if (!s.empty()) die_name = s;
-                break;
-            case DW_AT_data_member_location:
-                member_loc = v;
-                has_member_loc = true;
-                break;
-            case DW_AT_byte_size:
-                byte_sz = v;
-                has_byte_sz = true;
-                break;
-            case DW_AT_type:
-                type_ref = v;
-                type_ref_form = attr.form;
-                break;
-            default:
-                break;
-            }
-        }
-
-        // Convert CU-relative type ref to absolute .debug_info offset
-        uint64_t abs_type_ref = type_ref_form ?
-            (IsRelRef(type_ref_form) ? cu_base_offset + type_ref : type_ref) : 0;
+        const std::string& die_name = die.name;
+        uint64_t abs_type_ref = die.type_ref;
 
         // Handle DIE by tag
-        switch (entry.tag) {
+        switch (die.tag) {
         case DW_TAG_namespace: {
-            if (entry.has_children) {
+            if (die.has_children) {
                 std::string new_ns = cur_ns.empty() ? die_name
                                                     : (cur_ns + "::" + die_name);
                 stk.push({cur_ns, cur_struct_idx});
@@ -614,17 +642,17 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
                 std::string full_name = cur_ns.empty() ? die_name
                                                        : (cur_ns + "::" + die_name);
                 // Register in type registry so members/bases can reference this type
-                type_registry_[die_abs_offset] = {full_name, 0, 0};
+                out->types[die_abs_offset] = {full_name, 0, 0};
                 // push_back may reallocate; record index before, set after
-                structs_.push_back({full_name, (uint32_t)byte_sz, has_byte_sz, {}, {}});
-                int new_idx = (int)structs_.size() - 1;
-                if (entry.has_children) {
+                out->structs.push_back({full_name, (uint32_t)die.byte_size, die.has_byte_size, {}, {}});
+                int new_idx = (int)out->structs.size() - 1;
+                if (die.has_children) {
                     stk.push({cur_ns, cur_struct_idx});
                     cur_struct_idx = new_idx;
                 }
             } else {
                 // anonymous struct/class
-                if (entry.has_children) {
+                if (die.has_children) {
                     stk.push({cur_ns, cur_struct_idx});
                     cur_struct_idx = kNoStruct;
                 }
@@ -634,14 +662,14 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
 
         case DW_TAG_member: {
             if (cur_struct_idx != kNoStruct && !die_name.empty()) {
-                structs_[cur_struct_idx].members.push_back(
-                    {die_name, "", (uint32_t)member_loc, has_member_loc});
+                out->structs[cur_struct_idx].members.push_back(
+                    {die_name, "", (uint32_t)die.member_loc, die.has_member_loc});
                 if (abs_type_ref) {
-                    int member_idx = (int)structs_[cur_struct_idx].members.size() - 1;
-                    pending_refs_.push_back({cur_struct_idx, false, member_idx, abs_type_ref});
+                    int member_idx = (int)out->structs[cur_struct_idx].members.size() - 1;
+                    out->refs.push_back({cur_struct_idx, false, member_idx, abs_type_ref});
                 }
             }
-            if (entry.has_children) {
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
@@ -650,14 +678,14 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
 
         case DW_TAG_inheritance: {
             if (cur_struct_idx != kNoStruct) {
-                structs_[cur_struct_idx].bases.push_back(
-                    {"", (uint32_t)member_loc, has_member_loc});
+                out->structs[cur_struct_idx].bases.push_back(
+                    {"", (uint32_t)die.member_loc, die.has_member_loc});
                 if (abs_type_ref) {
-                    int base_idx = (int)structs_[cur_struct_idx].bases.size() - 1;
-                    pending_refs_.push_back({cur_struct_idx, true, base_idx, abs_type_ref});
+                    int base_idx = (int)out->structs[cur_struct_idx].bases.size() - 1;
+                    out->refs.push_back({cur_struct_idx, true, base_idx, abs_type_ref});
                 }
             }
-            if (entry.has_children) {
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
@@ -670,9 +698,9 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
             if (!die_name.empty()) {
                 std::string full_name = cur_ns.empty() ? die_name
                                                        : (cur_ns + "::" + die_name);
-                type_registry_[die_abs_offset] = {full_name, 0, 0};
+                out->types[die_abs_offset] = {full_name, 0, 0};
             }
-            if (entry.has_children) {
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
@@ -683,9 +711,9 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
             if (!die_name.empty()) {
                 std::string full_name = cur_ns.empty() ? die_name
                                                        : (cur_ns + "::" + die_name);
-                type_registry_[die_abs_offset] = {full_name, abs_type_ref, 5};
+                out->types[die_abs_offset] = {full_name, abs_type_ref, 5};
             }
-            if (entry.has_children) {
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
@@ -694,40 +722,40 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
 
         case DW_TAG_pointer_type:
         case DW_TAG_rvalue_reference_type:
-            type_registry_[die_abs_offset] = {"", abs_type_ref, 1};
-            if (entry.has_children) {
+            out->types[die_abs_offset] = {"", abs_type_ref, 1};
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
             break;
 
         case DW_TAG_reference_type:
-            type_registry_[die_abs_offset] = {"", abs_type_ref, 2};
-            if (entry.has_children) {
+            out->types[die_abs_offset] = {"", abs_type_ref, 2};
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
             break;
 
         case DW_TAG_const_type:
-            type_registry_[die_abs_offset] = {"", abs_type_ref, 3};
-            if (entry.has_children) {
+            out->types[die_abs_offset] = {"", abs_type_ref, 3};
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
             break;
 
         case DW_TAG_volatile_type:
-            type_registry_[die_abs_offset] = {"", abs_type_ref, 4};
-            if (entry.has_children) {
+            out->types[die_abs_offset] = {"", abs_type_ref, 4};
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
             break;
 
         case DW_TAG_array_type:
-            type_registry_[die_abs_offset] = {"", abs_type_ref, 6};
-            if (entry.has_children) {
+            out->types[die_abs_offset] = {"", abs_type_ref, 6};
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
@@ -735,7 +763,7 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
 
         default: {
             // Other tags (subprogram, …): push to skip children scope
-            if (entry.has_children) {
+            if (die.has_children) {
                 stk.push({cur_ns, cur_struct_idx});
                 cur_struct_idx = kNoStruct;
             }
@@ -747,10 +775,14 @@ const uint8_t* DwarfLoader::ParseDIETree(const uint8_t* ptr, const uint8_t* cu_e
     return ptr;
 }
 
-const uint8_t* DwarfLoader::ParseCompileUnit(const uint8_t* ptr, const uint8_t* end) {
+// Returns the end of this unit, unit->abbrev stays null for units without
+// structs to read (type units, missing abbrev table).
+const uint8_t* DwarfLoader::ParseUnitHeader(const uint8_t* ptr, const uint8_t* end,
+                                            UnitInfo* unit) {
     if (ptr + 4 > end) return nullptr;
 
     const uint8_t* cu_start = ptr; // CU-relative refs are relative to this
+    unit->abbrev = nullptr;
 
     // unit_length
     uint32_t unit_length_32 = (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8)
@@ -819,12 +851,11 @@ const uint8_t* DwarfLoader::ParseCompileUnit(const uint8_t* ptr, const uint8_t*
     }
 
     // Print first 3 CUs only to avoid flooding output on large .so files
-    static int cu_diag_count = 0;
-    bool diag = (cu_diag_count++ < 3);
+    bool diag = (units_.size() < 3);
     if (diag)
-        LOGD("CU#%d version=%u  unit_length=%lu  addr_size=%u"
+        LOGD("CU#%zu version=%u  unit_length=%lu  addr_size=%u"
              "  abbrev_offset=%lu  dwarf64=%d\n",
-             cu_diag_count, version, (unsigned long)unit_length, addr_size,
+             units_.size() + 1, version, (unsigned long)unit_length, addr_size,
              (unsigned long)abbrev_offset, (int)dwarf64);
 
     // Locate the abbrev table for this CU
@@ -867,62 +898,428 @@ const uint8_t* DwarfLoader::ParseCompileUnit(const uint8_t* ptr, const uint8_t*
         LOGD("str_offsets_base=%lu  abbrev_entries=%zu\n",
              (unsigned long)str_offsets_base, it->second.size());
 
-    uint64_t cu_base_offset = (uint64_t)(cu_start - debug_info_data_);
-    size_t structs_before = structs_.size();
-    const uint8_t* die_end = ParseDIETree(ptr, cu_end, addr_size, dwarf64,
-                                           it->second, "", str_offsets_base, cu_base_offset);
-    if (diag)
-        LOGD("structs found in this CU: %zu  (die_end=%s)\n",
-             structs_.size() - structs_before, die_end ? "ok" : "parse_error");
+    unit->offset = (uint64_t)(cu_start - debug_info_data_);
+    unit->end = (uint64_t)(cu_end - debug_info_data_);
+    unit->die = (uint64_t)(ptr - debug_info_data_);
+    unit->str_offsets_base = str_offsets_base;
+    unit->abbrev_offset = abbrev_offset;
+    unit->abbrev = &it->second;
+    unit->addr_size = addr_size;
+    unit->dwarf64 = dwarf64;
     return cu_end;
 }
 
-std::string DwarfLoader::ResolveTypeName(uint64_t offset, int depth) const {
-    if (depth > 8 || offset == 0) return "";
+uint32_t DwarfLoader::InternScope(const std::string& scope) {
+    auto it = scope_ids_.find(scope);
+    if (it != scope_ids_.end()) return it->second;
+    uint32_t id = (uint32_t)scope_names_.size();
+    scope_names_.push_back(scope);
+    scope_ids_[scope] = id;
+    return id;
+}
+
+const std::string& DwarfLoader::ScopeOf(uint64_t offset) const {
+    auto it = std::lower_bound(scopes_.begin(), scopes_.end(), offset,
+            [](const std::pair<uint64_t, uint32_t>& scope, uint64_t value) { return scope.first < value; });
+    if (it == scopes_.end() || it->first != offset)
+        return scope_names_[0];
+    return scope_names_[it->second];
+}
+
+// Same scoping as ParseDIETree, but keeps only where things are.
+void DwarfLoader::IndexUnit(const UnitInfo& unit, IndexedUnit* out) const {
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<uint32_t> stk;
+    uint32_t cur = 0;
+    const uint8_t* ptr = debug_info_data_ + unit.die;
+    const uint8_t* cu_end = debug_info_data_ + unit.end;
+    DieInfo die;
+
+    out->scopes.push_back("");
+    while (ptr < cu_end) {
+        uint64_t die_abs_offset = (uint64_t)(ptr - debug_info_data_);
+        ptr = ReadDIE(ptr, unit, false, &die);
+        if (!ptr) return;
+
+        if (die.code == 0) {
+            if (stk.empty()) break;
+            cur = stk.back();
+            stk.pop_back();
+            continue;
+        }
+
+        switch (die.tag) {
+        case DW_TAG_namespace:
+            if (die.has_children) {
+                const std::string& ns = out->scopes[cur];
+                std::string scope = ns.empty() ? die.name : (ns + "::" + die.name);
+                auto it = ids.emplace(scope, (uint32_t)out->scopes.size());
+                if (it.second) out->scopes.push_back(std::move(scope));
+                stk.push_back(cur);
+                cur = it.first->second;
+            }
+            continue;
+        case DW_TAG_structure_type:
+        case DW_TAG_class_type:
+            if (!die.name.empty() && die.has_byte_size) {
+                const std::string& ns = out->scopes[cur];
+                out->structs.push_back({ns.empty() ? die.name : (ns + "::" + die.name),
+                                        die_abs_offset});
+            }
+            [[fallthrough]];
+        case DW_TAG_base_type:
+        case DW_TAG_enumeration_type:
+        case DW_TAG_union_type:
+        case DW_TAG_typedef:
+            if (cur) out->scoped.push_back({die_abs_offset, cur});
+            break;
+        default:
+            break;
+        }
+        if (die.has_children) stk.push_back(cur);
+    }
+}
+
+void DwarfLoader::BuildIndex() {
+    if (!debug_info_data_) return;
+
+    const uint8_t* ptr = debug_info_data_;
+    const uint8_t* end = debug_info_data_ + debug_info_size_;
+
+    // unit lengths are known up front, the DIEs can be walked in parallel.
+    while (ptr < end) {
+        UnitInfo unit;
+        const uint8_t* next = ParseUnitHeader(ptr, end, &unit);
+        if (!next || next <= ptr) break;
+        if (unit.abbrev) units_.push_back(unit);
+        ptr = next;
+    }
+
+    std::vector<IndexedUnit> parts(units_.size());
+    ThreadPool::ParallelFor(units_.size(), [&](uint64_t index, int worker) {
+        IndexUnit(units_[index], &parts[index]);
+    });
+
+    // merge in unit order, the first definition of a name still wins.
+    InternScope("");
+    for (IndexedUnit& part : parts) {
+        std::vector<uint32_t> ids(part.scopes.size());
+        for (uint32_t i = 0; i < part.scopes.size(); ++i)
+            ids[i] = InternScope(part.scopes[i]);
+        for (const auto& scoped : part.scoped)
+            scopes_.push_back({scoped.first, ids[scoped.second]});
+        for (auto& st : part.structs)
+            struct_index_.emplace(std::move(st.first), st.second);
+        part = IndexedUnit();
+    }
+    indexed_ = true;
+    LOGD("total CUs indexed=%zu  structs=%zu  scoped types=%zu\n",
+         units_.size(), struct_index_.size(), scopes_.size());
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * | count | UnitInfo (abbrev as offset) ... | count | scope name ... |
+ * | count | (DIE offset, scope id) ... | count | (DIE offset, struct name) ... |
+ * ---------------------------------------------------------------------------
+ * counts are uint64_t, a name is a uint32_t length and its bytes.
+ */
+struct IndexedUnitRecord {
+    uint64_t offset;
+    uint64_t end;
+    uint64_t die;
+    uint64_t str_offsets_base;
+    uint64_t abbrev_offset;
+    uint32_t addr_size;
+    uint32_t dwarf64;
+};
+
+void DwarfLoader::WriteIndex(std::string& out) const {
+    auto put = [&](const void* data, uint64_t size) {
+        out.append(reinterpret_cast<const char*>(data), size);
+    };
+    auto put_name = [&](const std::string& name) {
+        uint32_t length = name.length();
+        put(&length, sizeof(length));
+        put(name.data(), length);
+    };
+
+    uint64_t count = units_.size();
+    put(&count, sizeof(count));
+    for (const UnitInfo& unit : units_) {
+        IndexedUnitRecord record = {unit.offset, unit.end, unit.die, unit.str_offsets_base,
+                                    unit.abbrev_offset, unit.addr_size, unit.dwarf64};
+        put(&record, sizeof(record));
+    }
+    count = scope_names_.size();
+    put(&count, sizeof(count));
+    for (const std::string& name : scope_names_)
+        put_name(name);
+    count = scopes_.size();
+    put(&count, sizeof(count));
+    for (const auto& scope : scopes_) {
+        put(&scope.first, sizeof(scope.first));
+        put(&scope.second, sizeof(scope.second));
+    }
+    count = struct_index_.size();
+    put(&count, sizeof(count));
+    for (const auto& st : struct_index_) {
+        put(&st.second, sizeof(st.second));
+        put_name(st.first);
+    }
+}
+
+// every offset must land in this file's sections, or nothing is taken.
+bool DwarfLoader::ReadIndex(const std::string& index) {
+    const char* cur = index.data();
+    const char* end = cur + index.size();
+    auto get = [&](void* out, uint64_t size) -> bool {
+        if (static_cast<uint64_t>(end - cur) < size)
+            return false;
+        memcpy(out, cur, size);
+        cur += size;
+        return true;
+    };
+    auto get_name = [&](std::string* name) -> bool {
+        uint32_t length;
+        if (!get(&length, sizeof(length)) || static_cast<uint64_t>(end - cur) < length)
+            return false;
+        name->assign(cur, length);
+        cur += length;
+        return true;
+    };
+
+    std::vector<UnitInfo> units;
+    std::vector<std::string> scope_names;
+    std::vector<std::pair<uint64_t, uint32_t>> scopes;
+    std::unordered_map<std::string, uint64_t> struct_index;
+    uint64_t count;
+
+    if (!get(&count, sizeof(count)) || count > index.size() / sizeof(IndexedUnitRecord))
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        IndexedUnitRecord record;
+        if (!get(&record, sizeof(record)))
+            return false;
+        auto it = abbrev_map_.find(record.abbrev_offset);
+        if (it == abbrev_map_.end()
+                || record.offset > record.die || record.die > record.end
+                || record.end > debug_info_size_
+                || (units.size() && units.back().end > record.offset))
+            return false;
+        units.push_back({record.offset, record.end, record.die, record.str_offsets_base,
+                         record.abbrev_offset, &it->second, record.addr_size, record.dwarf64 != 0});
+    }
+
+    if (!get(&count, sizeof(count)) || !count || count > index.size())
+        return false;
+    scope_names.resize(count);
+    for (std::string& name : scope_names) {
+        if (!get_name(&name))
+            return false;
+    }
+
+    if (!get(&count, sizeof(count)) || count > index.size())
+        return false;
+    scopes.resize(count);
+    for (auto& scope : scopes) {
+        if (!get(&scope.first, sizeof(scope.first)) || !get(&scope.second, sizeof(scope.second))
+                || scope.second >= scope_names.size() || scope.first >= debug_info_size_
+                || (&scope != &scopes[0] && (&scope - 1)->first >= scope.first))
+            return false;
+    }
+
+    if (!get(&count, sizeof(count)) || count > index.size())
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t offset;
+        std::string name;
+        if (!get(&offset, sizeof(offset)) || !get_name(&name) || offset >= debug_info_size_)
+            return false;
+        struct_index.emplace(std::move(name), offset);
+    }
+    if (cur != end)
+        return false;
+
+    units_ = std::move(units);
+    scope_names_ = std::move(scope_names);
+    scopes_ = std::move(scopes);
+    struct_index_ = std::move(struct_index);
+    scope_ids_.clear();
+    for (uint32_t i = 0; i < scope_names_.size(); ++i)
+        scope_ids_.emplace(scope_names_[i], i);
+    indexed_ = true;
+    LOGD("cached CUs indexed=%zu  structs=%zu  scoped types=%zu\n",
+         units_.size(), struct_index_.size(), scopes_.size());
+    return true;
+}
+
+const DwarfLoader::UnitInfo* DwarfLoader::FindUnit(uint64_t offset) const {
+    auto it = std::upper_bound(units_.begin(), units_.end(), offset,
+            [](uint64_t value, const UnitInfo& unit) { return value < unit.offset; });
+    if (it == units_.begin()) return nullptr;
+    --it;
+    if (offset < it->die || offset >= it->end) return nullptr;
+    return &*it;
+}
+
+// Registers the type DIE at offset the way ParseDIETree would, an empty
+// named entry stands for DIEs it never registers.
+const DwarfLoader::TypeEntry* DwarfLoader::DecodeType(uint64_t offset) {
     auto it = type_registry_.find(offset);
-    if (it == type_registry_.end()) return "";
-    const TypeEntry& e = it->second;
+    if (it != type_registry_.end()) return &it->second;
+
+    TypeEntry& entry = type_registry_[offset];
+    entry = {"", 0, 0};
+    const UnitInfo* unit = FindUnit(offset);
+    if (!unit) return &entry;
+
+    DieInfo die;
+    if (!ReadDIE(debug_info_data_ + offset, *unit, true, &die) || !die.code)
+        return &entry;
+
+    switch (die.tag) {
+    case DW_TAG_structure_type:
+    case DW_TAG_class_type:
+    case DW_TAG_base_type:
+    case DW_TAG_enumeration_type:
+    case DW_TAG_union_type:
+    case DW_TAG_typedef:
+        if (!die.name.empty()) {
+            const std::string& ns = ScopeOf(offset);
+            entry.name = ns.empty() ? die.name : (ns + "::" + die.name);
+            if (die.tag == DW_TAG_typedef)
+                entry = {entry.name, die.type_ref, 5};
+        }
+        break;
+    case DW_TAG_pointer_type:
+    case DW_TAG_rvalue_reference_type: entry = {"", die.type_ref, 1}; break;
+    case DW_TAG_reference_type:        entry = {"", die.type_ref, 2}; break;
+    case DW_TAG_const_type:            entry = {"", die.type_ref, 3}; break;
+    case DW_TAG_volatile_type:         entry = {"", die.type_ref, 4}; break;
+    case DW_TAG_array_type:            entry = {"", die.type_ref, 6}; break;
+    default:
+        break;
+    }
+    return &entry;
+}
+
+void DwarfLoader::DecodeStruct(uint64_t offset, StructInfo* si) {
+    const UnitInfo* unit = FindUnit(offset);
+    if (!unit) return;
+
+    DieInfo die;
+    const uint8_t* ptr = ReadDIE(debug_info_data_ + offset, *unit, false, &die);
+    if (!ptr || !die.code) return;
+    si->byte_size = (uint32_t)die.byte_size;
+    si->has_size = die.has_byte_size;
+    if (!die.has_children) return;
+
+    // only direct children belong to it, nested types come with their own.
+    const uint8_t* cu_end = debug_info_data_ + unit->end;
+    int depth = 1;
+    while (ptr < cu_end) {
+        ptr = ReadDIE(ptr, *unit, true, &die);
+        if (!ptr) break;
+        if (die.code == 0) {
+            if (--depth == 0) break;
+            continue;
+        }
+        if (depth == 1) {
+            if (die.tag == DW_TAG_member && !die.name.empty()) {
+                si->members.push_back({die.name, ResolveTypeName(die.type_ref),
+                                       (uint32_t)die.member_loc, die.has_member_loc});
+            } else if (die.tag == DW_TAG_inheritance) {
+                si->bases.push_back({ResolveTypeName(die.type_ref),
+                                     (uint32_t)die.member_loc, die.has_member_loc});
+            }
+        }
+        if (die.has_children) depth++;
+    }
+}
+
+std::string DwarfLoader::ResolveTypeName(uint64_t offset, int depth, const TypeLookup& lookup) {
+    if (depth > 8 || offset == 0) return "";
+    const TypeEntry* entry = lookup(offset);
+    if (!entry) return "";
+    const TypeEntry& e = *entry;
     switch (e.qualifier) {
-    case 0: return e.name;                                                       // named type
-    case 1: return ResolveTypeName(e.type_ref, depth + 1) + "*";                // pointer/rref
-    case 2: return ResolveTypeName(e.type_ref, depth + 1) + "&";                // reference
-    case 3: { auto s = ResolveTypeName(e.type_ref, depth + 1);                  // const
+    case 0: return e.name;                                                               // named type
+    case 1: return ResolveTypeName(e.type_ref, depth + 1, lookup) + "*";                // pointer/rref
+    case 2: return ResolveTypeName(e.type_ref, depth + 1, lookup) + "&";                // reference
+    case 3: { auto s = ResolveTypeName(e.type_ref, depth + 1, lookup);                  // const
               return s.empty() ? "const" : "const " + s; }
-    case 4: { auto s = ResolveTypeName(e.type_ref, depth + 1);                  // volatile
+    case 4: { auto s = ResolveTypeName(e.type_ref, depth + 1, lookup);                  // volatile
               return s.empty() ? "volatile" : "volatile " + s; }
-    case 5: return !e.name.empty() ? e.name : ResolveTypeName(e.type_ref, depth + 1); // typedef
-    case 6: return ResolveTypeName(e.type_ref, depth + 1) + "[]";               // array
+    case 5: return !e.name.empty() ? e.name : ResolveTypeName(e.type_ref, depth + 1, lookup); // typedef
+    case 6: return ResolveTypeName(e.type_ref, depth + 1, lookup) + "[]";               // array
     default: return e.name;
     }
 }
 
+std::string DwarfLoader::ResolveTypeName(uint64_t offset) {
+    return ResolveTypeName(offset, 0, [this](uint64_t type) { return DecodeType(type); });
+}
+
+// Resolves against the unit's own types, refs that leave the unit
+// (DW_FORM_ref_addr) are kept for ResolveTypes.
+void DwarfLoader::ResolveUnit(const UnitInfo& unit, ParsedUnit* part) const {
+    std::vector<PendingRef> foreign;
+    for (const auto& p : part->refs) {
+        if (p.type_offset == 0) continue;
+        bool left = false;
+        std::string name = ResolveTypeName(p.type_offset, 0, [&](uint64_t type) -> const TypeEntry* {
+            auto it = part->types.find(type);
+            if (it != part->types.end()) return &it->second;
+            if (type < unit.offset || type >= unit.end) left = true;
+            return nullptr;
+        });
+        if (left) {
+            foreign.push_back(p);
+            continue;
+        }
+        if (name.empty()) continue;
+        if (p.is_base)
+            part->structs[p.struct_idx].bases[p.item_idx].type_name = name;
+        else
+            part->structs[p.struct_idx].members[p.item_idx].type_name = name;
+    }
+    part->refs.swap(foreign);
+    std::unordered_map<uint64_t, TypeEntry>().swap(part->types);
+}
+
 void DwarfLoader::ResolveTypes() {
     for (const auto& p : pending_refs_) {
-        if (p.type_offset == 0) continue;
-        std::string name = ResolveTypeName(p.type_offset, 0);
+        std::string name = ResolveTypeName(p.type_offset);
         if (name.empty()) continue;
         if (p.is_base)
             structs_[p.struct_idx].bases[p.item_idx].type_name = name;
         else
             structs_[p.struct_idx].members[p.item_idx].type_name = name;
     }
+    std::vector<PendingRef>().swap(pending_refs_);
 }
 
 void DwarfLoader::ParseInfoSection() {
-    if (!debug_info_data_) return;
-
-    const uint8_t* ptr = debug_info_data_;
-    const uint8_t* end = debug_info_data_ + debug_info_size_;
-
-    int cu_count = 0;
-    while (ptr < end) {
-        const uint8_t* next = ParseCompileUnit(ptr, end);
-        if (!next || next <= ptr) break;
-        ptr = next;
-        ++cu_count;
+    std::vector<ParsedUnit> parts(units_.size());
+    ThreadPool::ParallelFor(units_.size(), [&](uint64_t index, int worker) {
+        ParseDIETree(units_[index], &parts[index]);
+        ResolveUnit(units_[index], &parts[index]);
+    });
+
+    // unit order keeps ForEachStruct in .debug_info order.
+    for (ParsedUnit& part : parts) {
+        int base = (int)structs_.size();
+        for (StructInfo& si : part.structs)
+            structs_.push_back(std::move(si));
+        for (PendingRef ref : part.refs) {
+            ref.struct_idx += base;
+            pending_refs_.push_back(ref);
+        }
+        part = ParsedUnit();
     }
-    LOGD("total CUs processed=%d  total structs=%zu\n",
-         cu_count, structs_.size());
+    LOGD("total CUs processed=%zu  total structs=%zu  cross-unit refs=%zu\n",
+         units_.size(), structs_.size(), pending_refs_.size());
     ResolveTypes();
 }
 
@@ -1078,7 +1475,7 @@ bool DwarfLoader::LocateSections() {
     return true;
 }
 
-bool DwarfLoader::Init(const char* elf_path) {
+bool DwarfLoader::Init(const char* elf_path, const std::string* index) {
     map_.reset(MemoryMap::MmapFile(elf_path));
     if (!map_) {
         LOGD("cannot open %s\n", elf_path);
@@ -1086,8 +1483,9 @@ bool DwarfLoader::Init(const char* elf_path) {
     }
     if (!LocateSections()) return false;
     ParseAbbrevSection();
-    ParseInfoSection();
-    if (structs_.empty()) {
+    if (!index || !index->length() || !ReadIndex(*index))
+        BuildIndex();
+    if (struct_index_.empty()) {
         LOGD("no struct/class types extracted from %s\n"
              "make sure the file is an unstripped debug build\n", elf_path);
         return false;
@@ -1097,11 +1495,35 @@ bool DwarfLoader::Init(const char* elf_path) {
 
 std::unique_ptr<DwarfLoader> DwarfLoader::Load(const char* elf_path) {
     auto loader = std::unique_ptr<DwarfLoader>(new DwarfLoader());
-    if (!loader->Init(elf_path)) return nullptr;
+    if (!loader->Init(elf_path, nullptr)) return nullptr;
+    return loader;
+}
+
+std::unique_ptr<DwarfLoader> DwarfLoader::Load(const char* elf_path, const std::string& index) {
+    auto loader = std::unique_ptr<DwarfLoader>(new DwarfLoader());
+    if (!loader->Init(elf_path, &index)) return nullptr;
     return loader;
 }
 
-void DwarfLoader::ForEachStruct(std::function<bool (const StructInfo&)> cb) const {
+const StructInfo* DwarfLoader::FindStruct(const std::string& name) {
+    auto it = struct_index_.find(name);
+    if (it == struct_index_.end()) return nullptr;
+    auto decoded = decoded_.find(it->second);
+    if (decoded != decoded_.end()) return &decoded->second;
+
+    StructInfo& si = decoded_[it->second];
+    si.name = name;
+    si.byte_size = 0;
+    si.has_size = false;
+    DecodeStruct(it->second, &si);
+    return &si;
+}
+
+void DwarfLoader::ForEachStruct(std::function<bool (const StructInfo&)> cb) {
+    if (!parsed_ && indexed_) {
+        ParseInfoSection();
+        parsed_ = true;
+    }
     for (const StructInfo& si : structs_)
         if (cb(si)) break;
 }
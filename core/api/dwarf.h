@@ -92,29 +92,96 @@ struct StructInfo {
     std::vector<MemberInfo> members;
 };
 
+/*
+ * Load only skip-scans .debug_info into a struct name -> DIE offset index,
+ * a struct and the types it references are decoded on first FindStruct.
+ * ForEachStruct still needs every struct and falls back to a full walk.
+ * The index itself round trips through WriteIndex, e.g. in the symbol
+ * cache, so a later Load of the same file skips the scan.
+ */
 class DwarfLoader {
 public:
     static std::unique_ptr<DwarfLoader> Load(const char* elf_path);
-    void ForEachStruct(std::function<bool (const StructInfo&)> cb) const;
+    // index from WriteIndex of the same file, an unusable one scans again.
+    static std::unique_ptr<DwarfLoader> Load(const char* elf_path, const std::string& index);
+    void WriteIndex(std::string& out) const;
+    // first definition (has_size) of name, null if none.
+    const StructInfo* FindStruct(const std::string& name);
+    void ForEachStruct(std::function<bool (const StructInfo&)> cb);
 
 private:
-    bool Init(const char* elf_path);
+    // Type registry: absolute .debug_info offset → type entry
+    struct TypeEntry {
+        std::string name;      // empty for unnamed (pointer/const/volatile/array)
+        uint64_t    type_ref;  // chained type offset (for pointer/typedef/const/...)
+        uint8_t     qualifier; // 0=named, 1=pointer/rref, 2=reference, 3=const,
+                               // 4=volatile, 5=typedef, 6=array
+    };
+
+    struct UnitInfo {
+        uint64_t offset;            // unit header, CU-relative refs base
+        uint64_t end;
+        uint64_t die;               // first DIE
+        uint64_t str_offsets_base;
+        uint64_t abbrev_offset;
+        const AbbrevTable* abbrev;
+        uint32_t addr_size;
+        bool dwarf64;
+    };
+
+    struct DieInfo {
+        uint64_t code;              // 0 for the null entry closing a scope
+        uint32_t tag;
+        bool has_children;
+        std::string name;
+        uint64_t member_loc;  bool has_member_loc;
+        uint64_t byte_size;   bool has_byte_size;
+        uint64_t type_ref;          // absolute .debug_info offset, 0 if none
+    };
+
+    struct PendingRef {
+        int      struct_idx;
+        bool     is_base;
+        int      item_idx;    // index into bases[] or members[]
+        uint64_t type_offset; // absolute .debug_info offset
+    };
+
+    // what one worker digs out of a unit, merged back in unit order.
+    struct IndexedUnit {
+        std::vector<std::string> scopes;                        // local id -> namespace, 0 is global
+        std::vector<std::pair<uint64_t, uint32_t>> scoped;      // DIE offset -> local id
+        std::vector<std::pair<std::string, uint64_t>> structs;  // full name -> DIE offset
+    };
+    struct ParsedUnit {
+        std::vector<StructInfo> structs;
+        std::vector<PendingRef> refs;   // struct_idx local to this unit
+        std::unordered_map<uint64_t, TypeEntry> types;
+    };
+    // null for offsets it can't answer.
+    using TypeLookup = std::function<const TypeEntry* (uint64_t offset)>;
+
+    bool Init(const char* elf_path, const std::string* index);
+    bool ReadIndex(const std::string& index);
     bool LocateSections();
     void ParseAbbrevSection();
     const uint8_t* ParseAbbrevTable(const uint8_t* ptr, const uint8_t* end,
                                     uint64_t base_offset);
+    const uint8_t* ParseUnitHeader(const uint8_t* ptr, const uint8_t* end, UnitInfo* unit);
+    const uint8_t* ReadDIE(const uint8_t* ptr, const UnitInfo& unit, bool names, DieInfo* die) const;
+    void BuildIndex();
+    void IndexUnit(const UnitInfo& unit, IndexedUnit* out) const;
+    const UnitInfo* FindUnit(uint64_t offset) const;
+    uint32_t InternScope(const std::string& scope);
+    const std::string& ScopeOf(uint64_t offset) const;
+    void DecodeStruct(uint64_t offset, StructInfo* si);
+    const TypeEntry* DecodeType(uint64_t offset);
     void ParseInfoSection();
-    const uint8_t* ParseCompileUnit(const uint8_t* ptr, const uint8_t* end);
-    const uint8_t* ParseDIETree(const uint8_t* ptr, const uint8_t* cu_end,
-                                uint32_t addr_size, bool dwarf64,
-                                const AbbrevTable& abbrev_table,
-                                const std::string& ns_prefix,
-                                uint64_t str_offsets_base,
-                                uint64_t cu_base_offset);
+    const uint8_t* ParseDIETree(const UnitInfo& unit, ParsedUnit* out) const;
+    void ResolveUnit(const UnitInfo& unit, ParsedUnit* part) const;
     const uint8_t* ReadAttrValue(const uint8_t* ptr, const uint8_t* end,
                                  uint32_t form, uint32_t addr_size, bool dwarf64,
                                  uint64_t str_offsets_base,
-                                 uint64_t* out_value, std::string* out_str);
+                                 uint64_t* out_value, std::string* out_str) const;
     static bool ParseExprloc(const uint8_t* data, uint64_t size, uint64_t* out_value);
     static uint64_t ReadULEB128(const uint8_t** ptr, const uint8_t* end);
     static int64_t  ReadSLEB128(const uint8_t** ptr, const uint8_t* end);
@@ -123,7 +190,8 @@ private:
     bool DecompressSection(const uint8_t* raw, uint64_t raw_size,
                            const uint8_t** out_data, uint64_t* out_size);
     void ResolveTypes();
-    std::string ResolveTypeName(uint64_t offset, int depth) const;
+    std::string ResolveTypeName(uint64_t offset);
+    static std::string ResolveTypeName(uint64_t offset, int depth, const TypeLookup& lookup);
 
     std::unique_ptr<MemoryMap> map_;
     const uint8_t* debug_abbrev_data_        = nullptr; uint64_t debug_abbrev_size_        = 0;
@@ -135,21 +203,20 @@ private:
     std::vector<StructInfo> structs_;
     std::vector<std::vector<uint8_t>> decompressed_sections_;
 
-    // Type registry: absolute .debug_info offset → type entry
-    struct TypeEntry {
-        std::string name;      // empty for unnamed (pointer/const/volatile/array)
-        uint64_t    type_ref;  // chained type offset (for pointer/typedef/const/...)
-        uint8_t     qualifier; // 0=named, 1=pointer/rref, 2=reference, 3=const,
-                               // 4=volatile, 5=typedef, 6=array
-    };
-    struct PendingRef {
-        int      struct_idx;
-        bool     is_base;
-        int      item_idx;    // index into bases[] or members[]
-        uint64_t type_offset; // absolute .debug_info offset
-    };
+    // types decoded on demand, and refs a unit could not resolve alone.
     std::unordered_map<uint64_t, TypeEntry> type_registry_;
     std::vector<PendingRef> pending_refs_;
+
+    // lazy index, DIEs are read back through the unit that holds them.
+    bool indexed_ = false;
+    bool parsed_ = false;
+    std::vector<UnitInfo> units_;
+    std::unordered_map<std::string, uint64_t> struct_index_;
+    std::unordered_map<uint64_t, StructInfo> decoded_;
+    // namespace of each named type DIE outside the global one, by offset.
+    std::vector<std::pair<uint64_t, uint32_t>> scopes_;
+    std::vector<std::string> scope_names_;
+    std::unordered_map<std::string, uint32_t> scope_ids_;
 };
 
 } // namespace dwarf
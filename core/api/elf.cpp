@@ -297,7 +297,7 @@ void Elf::ReadSymbols(LinkMap* handle) {
     if (!tables.IsValid() || !symbols.IsValid())
         return;
 
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash>& dynsyms = handle->GetDynsyms();
+    SymbolTable& dynsyms = handle->GetDynsyms();
     for (int i = 0; i < count; ++i) {
         if (symbols.st_value() && symbols.st_size()) {
             api::MemoryRef symname = tables.Ptr() + symbols.st_name();
@@ -312,7 +312,7 @@ void Elf::ReadSymbols(LinkMap* handle) {
             // skip mapping symbols and internal labels
             if (entry.symbol.size() > 0 && (entry.symbol[0] == '$' || entry.symbol[0] == '.'))
                 continue;
-            dynsyms.insert(entry);
+            dynsyms.Insert(entry);
         }
         symbols.MovePtr(syment);
     }
@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "api/core.h"
+#include "api/pointer_index.h"
+#include "base/crc32.h"
+#include "base/thread_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+std::unique_ptr<PointerIndex> PointerIndex::INSTANCE;
+
+static constexpr uint64_t kScanChunkSize = 16 * 1024 * 1024;
+static constexpr uint64_t kIdentityBytes = 4096;
+
+struct PointerEntry {
+    uint64_t target;
+    uint64_t source;
+
+    inline bool operator<(const PointerEntry& other) const {
+        if (target != other.target)
+            return target < other.target;
+        return source < other.source;
+    }
+    inline bool operator==(const PointerEntry& other) const {
+        return target == other.target && source == other.source;
+    }
+};
+
+static inline void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static inline uint64_t GetVarint(const uint8_t** cur) {
+    uint64_t value = 0;
+    int shift = 0;
+    const uint8_t* p = *cur;
+    while (*p & 0x80) {
+        value |= static_cast<uint64_t>(*p & 0x7F) << shift;
+        shift += 7;
+        p++;
+    }
+    value |= static_cast<uint64_t>(*p++) << shift;
+    *cur = p;
+    return value;
+}
+
+static inline uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static inline int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::string PointerIndex::GetPath() {
+    std::string path = CoreApi::GetName();
+    path.append(".ptridx");
+    return path;
+}
+
+uint64_t PointerIndex::Identity() {
+    uint32_t crc = Crc32::kInit;
+    auto callback = [&](LoadBlock *block) -> bool {
+        uint64_t layout[4] = { block->vaddr(), block->memsz(), block->realSize(), block->flags() };
+        crc = Crc32::Update(crc, reinterpret_cast<uint8_t*>(layout), sizeof(layout));
+        if (block->isValid()) {
+            crc = Crc32::Update(crc, reinterpret_cast<uint8_t*>(block->begin()),
+                                std::min(block->size(), kIdentityBytes));
+        }
+        return false;
+    };
+    CoreApi::ForeachLoadBlock(callback, false, false);
+
+    // writes live in overlays that die with this process, an index built
+    // after one must not match any other session or any later write.
+    uint64_t generation = CoreApi::GetWriteGeneration();
+    if (generation) {
+        uint64_t session[2] = { generation, static_cast<uint64_t>(getpid()) };
+        crc = Crc32::Update(crc, reinterpret_cast<uint8_t*>(session), sizeof(session));
+    }
+    return (static_cast<uint64_t>(CoreApi::GetPointSize()) << 32) | crc;
+}
+
+bool PointerIndex::Build(const char* path) {
+    struct Range {
+        uint64_t begin;
+        uint64_t end;
+    };
+    struct Chunk {
+        LoadBlock* block;
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<Range> ranges;
+    std::vector<Chunk> chunks;
+    auto callback = [&](LoadBlock *block) -> bool {
+        if (!block->isValid())
+            return false;
+        ranges.push_back({block->vaddr(), block->vaddr() + block->memsz()});
+        uint64_t size = block->size();
+        for (uint64_t offset = 0; offset < size; offset += kScanChunkSize)
+            chunks.push_back({block, offset, std::min(kScanChunkSize, size - offset)});
+        return false;
+    };
+    CoreApi::ForeachLoadBlock(callback, false, false);
+    if (ranges.empty())
+        return false;
+
+    int point_size = CoreApi::GetPointSize();
+    uint64_t mask = CoreApi::GetVabitsMask();
+    uint64_t lowest = ranges.front().begin;
+    uint64_t highest = ranges.back().end;
+
+    /*
+     * every chunk spills its sorted run to a scratch file as soon as it is
+     * done, memory holds one run per worker however large the core is.
+     * the merge below reads the runs back through a file mapping.
+     */
+    struct Run {
+        uint64_t offset;
+        uint64_t count;
+    };
+    std::string spill_path = std::string(path) + ".tmp";
+    FILE* spill = fopen(spill_path.c_str(), "wb");
+    if (!spill) {
+        LOGE("Can not create %s\n", spill_path.c_str());
+        return false;
+    }
+    std::vector<Run> runs(chunks.size());
+    std::mutex spill_lock;
+    uint64_t spilled = 0;
+    bool errors = false;
+    ThreadPool::ParallelFor(chunks.size(), [&](uint64_t index, int worker) {
+        Chunk& chunk = chunks[index];
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(chunk.block->begin()) + chunk.offset;
+        uint64_t vaddr = chunk.block->vaddr() + chunk.offset;
+        std::vector<PointerEntry> entries;
+        const Range* last = &ranges[0];
+
+        auto contains = [&](uint64_t value) -> bool {
+            if (value < lowest || value >= highest)
+                return false;
+            // pointers cluster, try the last hit first.
+            if (value >= last->begin && value < last->end)
+                return true;
+            const auto& it = std::upper_bound(ranges.begin(), ranges.end(), value,
+                    [](uint64_t v, const Range& range) { return v < range.begin; });
+            if (it == ranges.begin())
+                return false;
+            const Range& range = *(it - 1);
+            if (value >= range.end)
+                return false;
+            last = &range;
+            return true;
+        };
+
+        if (point_size == 8) {
+            for (uint64_t i = 0; i + 8 <= chunk.size; i += 8) {
+                uint64_t value;
+                memcpy(&value, data + i, sizeof(value));
+                value &= mask;
+                if (contains(value))
+                    entries.push_back({value, vaddr + i});
+            }
+        } else {
+            for (uint64_t i = 0; i + 4 <= chunk.size; i += 4) {
+                uint32_t value;
+                memcpy(&value, data + i, sizeof(value));
+                if (contains(value))
+                    entries.push_back({value, vaddr + i});
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+
+        std::lock_guard<std::mutex> guard(spill_lock);
+        runs[index] = {spilled, entries.size()};
+        if (entries.size())
+            errors |= !fwrite(entries.data(), sizeof(PointerEntry) * entries.size(), 1, spill);
+        spilled += entries.size();
+    });
+    errors |= fclose(spill) != 0;
+
+    std::unique_ptr<MemoryMap> runs_map;
+    if (!errors && spilled) {
+        runs_map.reset(MemoryMap::MmapFile(spill_path.c_str()));
+        errors |= !runs_map;
+    }
+    if (errors) {
+        LOGE("Write %s fail!\n", spill_path.c_str());
+        remove(spill_path.c_str());
+        return false;
+    }
+    const PointerEntry* spilled_entries = runs_map
+            ? reinterpret_cast<const PointerEntry*>(runs_map->data()) : nullptr;
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        LOGE("Can not create %s\n", path);
+        runs_map.reset();
+        remove(spill_path.c_str());
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0x0, sizeof(Header));
+    header.magic = kMagic;
+    header.identity = Identity();
+    header.point_size = point_size;
+    fwrite(&header, sizeof(Header), 1, fp);
+
+    // k-way merge sorted chunks straight into the encoder.
+    typedef std::pair<PointerEntry, uint64_t> HeapNode;  // (entry, chunk)
+    auto greater = [](const HeapNode& a, const HeapNode& b) { return b.first < a.first; };
+    std::priority_queue<HeapNode, std::vector<HeapNode>, decltype(greater)> heap(greater);
+    std::vector<uint64_t> cursors(runs.size(), 0);
+    for (uint64_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].count) heap.push({spilled_entries[runs[i].offset], i});
+    }
+
+    std::vector<Checkpoint> checkpoints;
+    std::vector<uint8_t> buffer;
+    PointerEntry prev = {0, 0};
+    PointerEntry encoded = {0, 0};
+    while (!heap.empty()) {
+        HeapNode node = heap.top();
+        heap.pop();
+        uint64_t chunk = node.second;
+        if (++cursors[chunk] < runs[chunk].count)
+            heap.push({spilled_entries[runs[chunk].offset + cursors[chunk]], chunk});
+
+        PointerEntry& entry = node.first;
+        if (header.count && entry == prev)
+            continue;
+        prev = entry;
+
+        if (header.count % kCheckpointInterval == 0) {
+            checkpoints.push_back({entry.target, header.data_size + buffer.size()});
+            encoded = {0, 0};
+        }
+
+        uint64_t delta = entry.target - encoded.target;
+        PutVarint(buffer, delta);
+        if (delta) {
+            PutVarint(buffer, ZigZag(static_cast<int64_t>(entry.source - entry.target)));
+        } else {
+            PutVarint(buffer, entry.source - encoded.source);
+        }
+        encoded = entry;
+        header.count++;
+
+        if (buffer.size() >= kScanChunkSize) {
+            errors |= !fwrite(buffer.data(), buffer.size(), 1, fp);
+            header.data_size += buffer.size();
+            buffer.clear();
+        }
+    }
+    if (buffer.size()) {
+        errors |= !fwrite(buffer.data(), buffer.size(), 1, fp);
+        header.data_size += buffer.size();
+    }
+    if (checkpoints.size())
+        errors |= !fwrite(checkpoints.data(), sizeof(Checkpoint) * checkpoints.size(), 1, fp);
+    header.checkpoints = checkpoints.size();
+
+    fseek(fp, 0, SEEK_SET);
+    errors |= !fwrite(&header, sizeof(Header), 1, fp);
+    fclose(fp);
+    runs_map.reset();
+    remove(spill_path.c_str());
+
+    if (errors) {
+        LOGE("Write %s fail!\n", path);
+        remove(path);
+        return false;
+    }
+    INSTANCE.reset();
+    return true;
+}
+
+PointerIndex* PointerIndex::Open(const char* path) {
+    if (INSTANCE && INSTANCE->mMap->getName() == path
+            && INSTANCE->mGeneration == CoreApi::GetWriteGeneration())
+        return INSTANCE.get();
+    INSTANCE.reset();
+
+    std::unique_ptr<MemoryMap> map(MemoryMap::MmapFile(path));
+    if (!map || map->size() < sizeof(Header))
+        return nullptr;
+
+    Header* header = reinterpret_cast<Header*>(map->data());
+    if (header->magic != kMagic
+            || header->identity != Identity()
+            || sizeof(Header) + header->data_size
+                    + header->checkpoints * sizeof(Checkpoint) > map->size())
+        return nullptr;
+
+    INSTANCE.reset(new PointerIndex(map.release(), CoreApi::GetWriteGeneration()));
+    return INSTANCE.get();
+}
+
+void PointerIndex::Find(uint64_t min, uint64_t max, std::function<bool (uint64_t target, uint64_t source)> fn) {
+    Header* hdr = header();
+    if (!hdr->checkpoints || min >= max)
+        return;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(mMap->data() + sizeof(Header));
+    const Checkpoint* checkpoints = reinterpret_cast<const Checkpoint*>(data + hdr->data_size);
+    const Checkpoint* end = checkpoints + hdr->checkpoints;
+
+    // equal targets may spill over into the previous checkpoint.
+    const Checkpoint* it = std::lower_bound(checkpoints, end, min,
+            [](const Checkpoint& checkpoint, uint64_t value) { return checkpoint.target < value; });
+    if (it != checkpoints) --it;
+
+    const uint8_t* cur = data + it->offset;
+    const uint8_t* limit = data + hdr->data_size;
+    uint64_t index = (it - checkpoints) * kCheckpointInterval;
+    uint64_t target = 0;
+    uint64_t source = 0;
+    while (cur < limit) {
+        if (index % kCheckpointInterval == 0) {
+            target = 0;
+            source = 0;
+        }
+        uint64_t delta = GetVarint(&cur);
+        if (delta) {
+            target += delta;
+            source = target + UnZigZag(GetVarint(&cur));
+        } else {
+            source += GetVarint(&cur);
+        }
+        index++;
+
+        if (target >= max)
+            break;
+        if (target >= min && fn(target, source))
+            break;
+    }
+}
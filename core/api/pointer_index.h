@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_API_POINTER_INDEX_H_
+#define CORE_API_POINTER_INDEX_H_
+
+#include "base/memory_map.h"
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <functional>
+
+/*
+ * "who points here" index, (target -> source) sorted by target.
+ *
+ *  -------------------------------------------------------
+ * | Header | entries (varint deltas) ... | Checkpoint[] ... |
+ *  -------------------------------------------------------
+ *
+ * Every kCheckpointInterval entries restart from (0, 0), a query binary
+ * searches the checkpoints and decodes forward from there. A source is
+ * any pointer-size aligned word that points into a valid load block.
+ */
+class PointerIndex {
+public:
+    static constexpr uint64_t kMagic = 0x3230584449525450ULL; // "PTRIDX02"
+    static constexpr uint64_t kCheckpointInterval = 256;
+
+    struct Header {
+        uint64_t magic;
+        uint64_t identity;
+        uint32_t point_size;
+        uint32_t reserved;
+        uint64_t count;
+        uint64_t data_size;
+        uint64_t checkpoints;
+    };
+
+    struct Checkpoint {
+        uint64_t target;
+        uint64_t offset;
+    };
+
+    static std::string GetPath();
+    static bool Build(const char* path);
+    // null if the file is missing, was built from another core or memory
+    // has been written since, "cs --index" again rebuilds it.
+    static PointerIndex* Open(const char* path);
+
+    uint64_t size() { return header()->count; }
+    // sources pointing into [min, max) ordered by target, fn returns true to stop.
+    void Find(uint64_t min, uint64_t max, std::function<bool (uint64_t target, uint64_t source)> fn);
+private:
+    static uint64_t Identity();
+    PointerIndex(MemoryMap* map, uint64_t generation) : mMap(map), mGeneration(generation) {}
+    Header* header() { return reinterpret_cast<Header*>(mMap->data()); }
+
+    std::unique_ptr<MemoryMap> mMap;
+    uint64_t mGeneration;
+    static std::unique_ptr<PointerIndex> INSTANCE;
+};
+
+#endif // CORE_API_POINTER_INDEX_H_
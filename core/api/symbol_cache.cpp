@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "api/symbol_cache.h"
+#include "common/link_map.h"
+#include "base/memory_map.h"
+#include <linux/elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <vector>
+
+#ifndef NT_GNU_BUILD_ID
+#define NT_GNU_BUILD_ID 3
+#endif
+
+static std::string& CacheDir() {
+    static std::string dir = getenv("CORE_PARSER_CACHE_DIR") ? getenv("CORE_PARSER_CACHE_DIR") : "";
+    return dir;
+}
+
+void SymbolCache::SetDir(const char* dir) {
+    CacheDir() = dir;
+    if (CacheDir().length())
+        mkdir(CacheDir().c_str(), 0755);
+}
+
+std::string& SymbolCache::GetDir() {
+    return CacheDir();
+}
+
+template <typename Ehdr, typename Phdr, typename Nhdr>
+static std::string FindBuildId(const uint8_t* data, uint64_t size) {
+    if (size < sizeof(Ehdr))
+        return "";
+    const Ehdr* ehdr = reinterpret_cast<const Ehdr*>(data);
+    if (ehdr->e_phoff + ehdr->e_phnum * sizeof(Phdr) > size)
+        return "";
+
+    const Phdr* phdr = reinterpret_cast<const Phdr*>(data + ehdr->e_phoff);
+    for (int i = 0; i < ehdr->e_phnum; ++i) {
+        if (phdr[i].p_type != PT_NOTE || phdr[i].p_offset + phdr[i].p_filesz > size)
+            continue;
+
+        const uint8_t* cur = data + phdr[i].p_offset;
+        const uint8_t* end = cur + phdr[i].p_filesz;
+        while (cur + sizeof(Nhdr) <= end) {
+            const Nhdr* note = reinterpret_cast<const Nhdr*>(cur);
+            const uint8_t* name = cur + sizeof(Nhdr);
+            const uint8_t* desc = name + ((note->n_namesz + 3) & ~3);
+            if (desc + note->n_descsz > end)
+                break;
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4
+                    && !memcmp(name, "GNU", 4)) {
+                std::string id;
+                char hex[3];
+                for (int k = 0; k < note->n_descsz; ++k) {
+                    snprintf(hex, sizeof(hex), "%02x", desc[k]);
+                    id.append(hex);
+                }
+                return id;
+            }
+            cur = desc + ((note->n_descsz + 3) & ~3);
+        }
+    }
+    return "";
+}
+
+std::string SymbolCache::GetBuildId(LoadBlock* block) {
+    if (!block || !block->isMmapBlock())
+        return "";
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(block->begin(Block::OPT_READ_MMAP));
+    uint64_t size = block->size(Block::OPT_READ_MMAP);
+    if (size < EI_NIDENT || memcmp(data, ELFMAG, SELFMAG))
+        return "";
+
+    if (data[EI_CLASS] == ELFCLASS64)
+        return FindBuildId<Elf64_Ehdr, Elf64_Phdr, Elf64_Nhdr>(data, size);
+    return FindBuildId<Elf32_Ehdr, Elf32_Phdr, Elf32_Nhdr>(data, size);
+}
+
+std::string SymbolCache::GetPath(LoadBlock* block) {
+    if (!GetDir().length())
+        return "";
+    std::string id = GetBuildId(block);
+    struct stat sb;
+    if (!id.length() || stat(block->name().c_str(), &sb))
+        return "";
+    return GetDir() + "/" + id + "-" + std::to_string(sb.st_size) + ".symcache";
+}
+
+bool SymbolCache::Load(LoadBlock* block, std::string& dwarf) {
+    std::string path = GetPath(block);
+    if (!path.length() || access(path.c_str(), R_OK))
+        return false;
+
+    if (!Read(path.c_str(), LinkMap::SymbolMask(), block->GetSymbols(), dwarf)) {
+        LOGW("Ignore bad symbol cache %s\n", path.c_str());
+        return false;
+    }
+    LOGD("Load symbol cache %s\n", path.c_str());
+    return true;
+}
+
+bool SymbolCache::Save(LoadBlock* block, dwarf::DwarfLoader* loader) {
+    std::string path = GetPath(block);
+    if (!path.length())
+        return false;
+
+    std::string dwarf;
+    if (loader)
+        loader->WriteIndex(dwarf);
+    if (!Write(path.c_str(), LinkMap::SymbolMask(), block->GetSymbols(), dwarf))
+        return false;
+    LOGD("Save symbol cache %s\n", path.c_str());
+    return true;
+}
+
+bool SymbolCache::Read(const char* path, uint64_t mask, SymbolTable& symbols, std::string& dwarf) {
+    std::unique_ptr<MemoryMap> map(MemoryMap::MmapFile(path));
+    if (!map || map->size() < sizeof(Header))
+        return false;
+
+    const Header* header = reinterpret_cast<const Header*>(map->data());
+    if (header->magic != kMagic || header->version != kVersion
+            || header->record_size != sizeof(SymbolTable::Record)
+            || header->mask != mask
+            || header->records > (map->size() - sizeof(Header)) / sizeof(SymbolTable::Record))
+        return false;
+
+    uint64_t records_size = header->records * sizeof(SymbolTable::Record);
+    if (header->names_size > map->size() - sizeof(Header) - records_size
+            || header->dwarf_size != map->size() - sizeof(Header) - records_size - header->names_size)
+        return false;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(map->data()) + sizeof(Header);
+    const SymbolTable::Record* records = reinterpret_cast<const SymbolTable::Record*>(data);
+    const char* names = reinterpret_cast<const char*>(data + records_size);
+
+    // every name must start inside the pool and end before its tail.
+    if (header->records && (!header->names_size || names[header->names_size - 1]))
+        return false;
+    for (uint64_t i = 0; i < header->records; ++i) {
+        if (records[i].name >= header->names_size)
+            return false;
+    }
+
+    dwarf.assign(names + header->names_size, header->dwarf_size);
+    symbols.Adopt(map, records, header->records, names, mask);
+    return true;
+}
+
+bool SymbolCache::Write(const char* path, uint64_t mask, SymbolTable& symbols, const std::string& dwarf) {
+    std::vector<SymbolTable::Record> records(symbols.GetRecords());
+    std::vector<char> names;
+    for (auto& record : records) {
+        const char* name = symbols.Name(record);
+        record.strtab = 0;
+        record.name = names.size();
+        names.insert(names.end(), name, name + strlen(name) + 1);
+    }
+
+    Header header;
+    memset(&header, 0x0, sizeof(Header));
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.record_size = sizeof(SymbolTable::Record);
+    header.mask = mask;
+    header.records = records.size();
+    header.names_size = names.size();
+    header.dwarf_size = dwarf.length();
+
+    // other sessions may read the same id, publish it whole.
+    std::string tmp = std::string(path) + "." + std::to_string(getpid());
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (!fp) {
+        LOGW("Can not create %s\n", tmp.c_str());
+        return false;
+    }
+    bool errors = !fwrite(&header, sizeof(Header), 1, fp);
+    if (records.size())
+        errors |= !fwrite(records.data(), sizeof(SymbolTable::Record) * records.size(), 1, fp);
+    if (names.size())
+        errors |= !fwrite(names.data(), names.size(), 1, fp);
+    if (dwarf.length())
+        errors |= !fwrite(dwarf.data(), dwarf.length(), 1, fp);
+    errors |= fclose(fp) != 0;
+
+    if (errors || rename(tmp.c_str(), path)) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_API_SYMBOL_CACHE_H_
+#define CORE_API_SYMBOL_CACHE_H_
+
+#include "common/load_block.h"
+#include "common/symbol_table.h"
+#include "api/dwarf.h"
+#include <stdint.h>
+#include <string>
+
+/*
+ * Pre-digested symbols of one ELF, <dir>/<build-id>-<file size>.symcache
+ *
+ *  ---------------------------------------------------------------------
+ * | Header | SymbolTable::Record[] (sorted) | names ... | dwarf index |
+ *  ---------------------------------------------------------------------
+ *
+ * Records and names are used straight from the mapping, no sort and no
+ * string copies. The dwarf index is DwarfLoader::WriteIndex, it spares the
+ * .debug_info scan, structs are still decoded from the ELF on lookup.
+ * A stripped and an unstripped file share the build-id, the file size
+ * keeps their symbol sets apart. Disabled until a directory is set by
+ * "env config --cache" or CORE_PARSER_CACHE_DIR.
+ */
+class SymbolCache {
+public:
+    static constexpr uint64_t kMagic = 0x31484341434d5953ULL; // "SYMCACH1"
+    static constexpr uint32_t kVersion = 3;
+
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t mask;
+        uint64_t records;
+        uint64_t names_size;
+        uint64_t dwarf_size;
+    };
+
+    static void SetDir(const char* dir);
+    static std::string& GetDir();
+    static std::string GetBuildId(LoadBlock* block);
+
+    static bool Load(LoadBlock* block, std::string& dwarf);
+    static bool Save(LoadBlock* block, dwarf::DwarfLoader* loader);
+    // the file alone, a damaged file fails Read and leaves symbols untouched.
+    static bool Read(const char* path, uint64_t mask, SymbolTable& symbols, std::string& dwarf);
+    static bool Write(const char* path, uint64_t mask, SymbolTable& symbols, const std::string& dwarf);
+private:
+    static std::string GetPath(LoadBlock* block);
+};
+
+#endif // CORE_API_SYMBOL_CACHE_H_
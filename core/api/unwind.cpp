@@ -22,6 +22,7 @@
 #include "x86_64/unwind.h"
 #include "riscv64/unwind.h"
 #include "common/elf.h"
+#include "common/exception.h"
 
 namespace api {
 
@@ -44,6 +45,65 @@ void UnwindStack::VisitFrame() {
     cur_num_++;
 }
 
+void UnwindStack::Prepare() {
+    auto callback = [](LinkMap* map) -> bool {
+        try {
+            map->name();
+            map->block();
+            map->GetEhFrame();
+            // sorts symbols still dirty from Insert().
+            map->GetCurrentSymbols().FindRegion(0x0);
+        } catch(InvalidAddressException& e) {}
+        return false;
+    };
+    CoreApi::ForeachLinkMap(callback);
+    // builds the LinkMap interval index.
+    CoreApi::FindLinkMap(0x0, nullptr);
+}
+
+bool UnwindStack::CfiBacktrace(EhFrame::Regs& regs, int sp, int fp, uint64_t rewind) {
+    LoadBlock* vdso = CoreApi::FindLoadBlock(CoreApi::FindAuxv(AT_SYSINFO_EHDR), false);
+    uint64_t visited = native_frames_.size();
+    try {
+        for (uint64_t depth = 0; depth < kMaxCfiFrames; ++depth) {
+            cur_frame_pc_ = regs.pc;
+            cur_frame_sp_ = regs.has(sp) ? regs.value[sp] : 0x0;
+            cur_frame_fp_ = regs.has(fp) ? regs.value[fp] : 0x0;
+
+            EhFrame* eh_frame = EhFrame::Find(regs.pc);
+            if (!eh_frame && !depth)
+                return false;
+            VisitFrame();
+            if (!eh_frame)
+                return true;
+
+            uint64_t prev_pc = regs.pc;
+            int ret = eh_frame->Step(sp, regs);
+            if (ret == EhFrame::STEP_FAIL) {
+                if (depth) return true;
+                native_frames_.pop_back();
+                cur_num_--;
+                return false;
+            }
+            if (ret == EhFrame::STEP_END)
+                break;
+
+            // stack only grows towards callers.
+            uint64_t pc = regs.pc & CoreApi::GetVabitsMask();
+            if (!pc || regs.value[sp] < cur_frame_sp_
+                    || (regs.value[sp] == cur_frame_sp_ && pc == prev_pc))
+                break;
+            if (!vdso || !vdso->virtualContains(pc))
+                pc -= rewind;
+            regs.pc = pc;
+        }
+    } catch(InvalidAddressException& e) {
+        // do nothing
+    }
+    cur_frame_fp_ = 0x0;
+    return native_frames_.size() > visited;
+}
+
 std::unique_ptr<UnwindStack> UnwindStack::MakeUnwindStack(ThreadApi* thread) {
     std::unique_ptr<UnwindStack> unwind;
     int machine = CoreApi::GetMachine();
@@ -19,6 +19,7 @@
 
 #include "api/thread.h"
 #include "common/native_frame.h"
+#include "common/eh_frame.h"
 #include <vector>
 #include <memory>
 
@@ -26,6 +27,8 @@ namespace api {
 
 class UnwindStack {
 public:
+    static constexpr uint64_t kMaxCfiFrames = 256;
+
     UnwindStack(ThreadApi* thread) : thread_(thread),
         cur_uc_(0), cur_num_(0), uc_num_(-1) {
         cur_frame_fp_ = 0x0;
@@ -39,9 +42,18 @@ public:
     virtual void WalkStack() = 0;
     virtual void DumpContextRegister(const char* prefix) = 0;
     static std::unique_ptr<UnwindStack> MakeUnwindStack(ThreadApi* thread);
+    // fill lazy LinkMap caches first, then threads may be walked in parallel.
+    static void Prepare();
     inline uint64_t GetContextNum() { return uc_num_; }
     inline uint64_t GetContext() { return cur_uc_; }
     void VisitFrame();
+    /*
+     * Visits regs.pc and the callers eh_frame can step to, with return
+     * addresses rewound into the call. False if the first frame has no
+     * rule and nothing was visited, otherwise cur_frame_fp_ is the last
+     * frame's fp to go on by frame pointers, or 0 at the outermost frame.
+     */
+    bool CfiBacktrace(EhFrame::Regs& regs, int sp, int fp, uint64_t rewind);
 protected:
     std::vector<std::unique_ptr<NativeFrame>> native_frames_;
     uint64_t cur_frame_fp_;
@@ -64,7 +64,7 @@ uint64_t UnwindStack::GetUContext() {
 void UnwindStack::WalkStack() {
     ThreadInfo* thread = reinterpret_cast<ThreadInfo*>(GetThread());
     Register& regs = thread->GetRegs();
-    FpBacktrace(regs);
+    Backtrace(regs);
 
     api::MemoryRef uc = GetUContext();
     if (uc.Ptr()) {
@@ -72,7 +72,22 @@ void UnwindStack::WalkStack() {
         struct ucontext* context = (struct ucontext*)uc.Real();
         Register uc_regs;
         memcpy(&uc_regs, &context->uc_mcontext.regs, sizeof(Register));
-        FpBacktrace(uc_regs);
+        Backtrace(uc_regs);
+    }
+}
+
+void UnwindStack::Backtrace(Register& regs) {
+    // x0 ... x30, sp are dwarf registers 0 ... 31
+    EhFrame::Regs cfi;
+    uint64_t* x = &regs.x0;
+    for (int i = 0; i <= 31; ++i)
+        cfi.set(i, x[i]);
+    cfi.pc = regs.pc;
+
+    if (CfiBacktrace(cfi, 31, 29, 0x4)) {
+        OnlyFpBackStack(cur_frame_fp_);
+    } else {
+        FpBacktrace(regs);
     }
 }
 
@@ -26,6 +26,7 @@ class UnwindStack : public api::UnwindStack {
 public:
     UnwindStack(ThreadApi* thread) : api::UnwindStack(thread) {}
     void WalkStack();
+    void Backtrace(Register& regs);
     void FpBacktrace(Register& regs);
     void OnlyFpBackStack(uint64_t fp);
     uint64_t GetUContext();
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/demangle_cache.h"
+#include "llvm/Demangle/Demangle.h"
+#include <string.h>
+#include <algorithm>
+
+std::string DemangleCache::Demangle(const char* symbol) {
+    char* demangled_name = llvm::itaniumDemangle(symbol);
+    if (!demangled_name)
+        demangled_name = llvm::rustDemangle(symbol);
+    if (!demangled_name)
+        return symbol;
+
+    std::string name(demangled_name);
+    std::free(demangled_name);
+    return name;
+}
+
+std::string_view DemangleCache::Find(LinkMap* map, uint64_t offset, const char* symbol, std::string& storage) {
+    Key key = {map, offset, symbol};
+    Shard& shard = shards[KeyHash()(key) % kShards];
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.names.find(key);
+        if (it != shard.names.end())
+            return it->second;
+    }
+
+    // demangle outside the lock, a racing thread just finds it kept.
+    storage = Demangle(symbol);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.names.find(key);
+    if (it != shard.names.end())
+        return it->second;
+    if (shard.used + key.symbol.length() + storage.length() + 2 > kMaxBytes / kShards)
+        return std::string_view();
+
+    key.symbol = std::string_view(Intern(shard, key.symbol), key.symbol.length());
+    std::string_view name(Intern(shard, storage), storage.length());
+    shard.names.emplace(key, name);
+    return name;
+}
+
+const char* DemangleCache::Intern(Shard& shard, std::string_view name) {
+    uint64_t length = name.length() + 1;
+    if (length > shard.pool_left) {
+        uint64_t size = std::max(kPoolChunkSize, length);
+        shard.pool.push_back(std::make_unique<char[]>(size));
+        shard.pool_cur = shard.pool.back().get();
+        shard.pool_left = size;
+    }
+    char* dst = shard.pool_cur;
+    memcpy(dst, name.data(), name.length());
+    dst[name.length()] = '\0';
+    shard.pool_cur += length;
+    shard.pool_left -= length;
+    shard.used += length;
+    return dst;
+}
+
+void DemangleCache::Clean() {
+    for (int i = 0; i < kShards; ++i) {
+        Shard& shard = shards[i];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.names.clear();
+        shard.pool.clear();
+        shard.pool_cur = nullptr;
+        shard.pool_left = 0;
+        shard.used = 0;
+    }
+}
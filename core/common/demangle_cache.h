@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_COMMON_DEMANGLE_CACHE_H_
+#define CORE_COMMON_DEMANGLE_CACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+class LinkMap;
+
+/*
+ * Demangled names by (LinkMap, symbol offset, symbol), shared by all frames.
+ *
+ *   shard[hash % kShards]:  lock | (map, offset, symbol) -> name | pool chunks
+ *
+ * Aliases share an offset, so the mangled symbol is part of the key.
+ * Names are copied into chunked pools and handed out as views that stay
+ * valid until Clean(), which runs whenever link maps or their symbols
+ * change. After kMaxBytes nothing new is kept, Find() then demangles
+ * into the caller's storage instead.
+ */
+class DemangleCache {
+public:
+    static constexpr int kShards = 16;
+    static constexpr uint64_t kPoolChunkSize = 256 * 1024;
+    static constexpr uint64_t kMaxBytes = 32 * 1024 * 1024;
+
+    DemangleCache() {}
+
+    // itanium or rust demangled symbol, symbol itself if it isn't mangled.
+    static std::string Demangle(const char* symbol);
+    // a view into the cache, or empty with the name left in storage.
+    std::string_view Find(LinkMap* map, uint64_t offset, const char* symbol, std::string& storage);
+    void Clean();
+private:
+    struct Key {
+        LinkMap* map;
+        uint64_t offset;
+        std::string_view symbol;  // interned once kept
+
+        inline bool operator==(const Key& other) const {
+            return map == other.map && offset == other.offset && symbol == other.symbol;
+        }
+    };
+
+    struct KeyHash {
+        inline std::size_t operator()(const Key& key) const {
+            uint64_t hash = (reinterpret_cast<uint64_t>(key.map) ^ key.offset) * 0x9E3779B97F4A7C15ULL >> 16;
+            return hash ^ std::hash<std::string_view>()(key.symbol);
+        }
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<Key, std::string_view, KeyHash> names;
+        std::vector<std::unique_ptr<char[]>> pool;
+        char* pool_cur = nullptr;
+        uint64_t pool_left = 0;
+        uint64_t used = 0;
+    };
+
+    const char* Intern(Shard& shard, std::string_view name);
+
+    Shard shards[kShards];
+};
+
+#endif // CORE_COMMON_DEMANGLE_CACHE_H_
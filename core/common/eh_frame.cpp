@@ -0,0 +1,593 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "api/core.h"
+#include "api/elf.h"
+#include "common/eh_frame.h"
+#include "common/link_map.h"
+#include "common/exception.h"
+#include <string.h>
+#include <algorithm>
+
+#ifndef PT_GNU_EH_FRAME
+#define PT_GNU_EH_FRAME 0x6474e550
+#endif
+
+// DW_EH_PE pointer encodings
+static constexpr uint8_t DW_EH_PE_absptr   = 0x00;
+static constexpr uint8_t DW_EH_PE_uleb128  = 0x01;
+static constexpr uint8_t DW_EH_PE_udata2   = 0x02;
+static constexpr uint8_t DW_EH_PE_udata4   = 0x03;
+static constexpr uint8_t DW_EH_PE_udata8   = 0x04;
+static constexpr uint8_t DW_EH_PE_sleb128  = 0x09;
+static constexpr uint8_t DW_EH_PE_sdata2   = 0x0a;
+static constexpr uint8_t DW_EH_PE_sdata4   = 0x0b;
+static constexpr uint8_t DW_EH_PE_sdata8   = 0x0c;
+static constexpr uint8_t DW_EH_PE_pcrel    = 0x10;
+static constexpr uint8_t DW_EH_PE_datarel  = 0x30;
+static constexpr uint8_t DW_EH_PE_indirect = 0x80;
+static constexpr uint8_t DW_EH_PE_omit     = 0xff;
+
+// DW_CFA instructions
+static constexpr uint8_t DW_CFA_advance_loc        = 0x40;
+static constexpr uint8_t DW_CFA_offset             = 0x80;
+static constexpr uint8_t DW_CFA_restore            = 0xc0;
+static constexpr uint8_t DW_CFA_nop                = 0x00;
+static constexpr uint8_t DW_CFA_set_loc            = 0x01;
+static constexpr uint8_t DW_CFA_advance_loc1       = 0x02;
+static constexpr uint8_t DW_CFA_advance_loc2       = 0x03;
+static constexpr uint8_t DW_CFA_advance_loc4       = 0x04;
+static constexpr uint8_t DW_CFA_offset_extended    = 0x05;
+static constexpr uint8_t DW_CFA_restore_extended   = 0x06;
+static constexpr uint8_t DW_CFA_undefined          = 0x07;
+static constexpr uint8_t DW_CFA_same_value         = 0x08;
+static constexpr uint8_t DW_CFA_register           = 0x09;
+static constexpr uint8_t DW_CFA_remember_state     = 0x0a;
+static constexpr uint8_t DW_CFA_restore_state      = 0x0b;
+static constexpr uint8_t DW_CFA_def_cfa            = 0x0c;
+static constexpr uint8_t DW_CFA_def_cfa_register   = 0x0d;
+static constexpr uint8_t DW_CFA_def_cfa_offset     = 0x0e;
+static constexpr uint8_t DW_CFA_def_cfa_expression = 0x0f;
+static constexpr uint8_t DW_CFA_expression         = 0x10;
+static constexpr uint8_t DW_CFA_offset_extended_sf = 0x11;
+static constexpr uint8_t DW_CFA_def_cfa_sf         = 0x12;
+static constexpr uint8_t DW_CFA_def_cfa_offset_sf  = 0x13;
+static constexpr uint8_t DW_CFA_val_offset         = 0x14;
+static constexpr uint8_t DW_CFA_val_offset_sf      = 0x15;
+static constexpr uint8_t DW_CFA_val_expression     = 0x16;
+static constexpr uint8_t DW_CFA_AARCH64_negate_ra_state = 0x2d;
+static constexpr uint8_t DW_CFA_GNU_args_size      = 0x2e;
+static constexpr uint8_t DW_CFA_GNU_negative_offset_extended = 0x2f;
+
+/*
+ * Reads straight from the load block holding vaddr, any overrun only
+ * sets errors so a damaged table ends the lookup instead of throwing.
+ */
+class EhReader {
+public:
+    EhReader(uint64_t vaddr) : base(vaddr), cur(nullptr), start(nullptr), end(nullptr), errors(false) {
+        LoadBlock* block = CoreApi::FindLoadBlock(vaddr, false);
+        if (!block || !block->isValid() || vaddr - block->vaddr() >= block->size()) {
+            errors = true;
+            return;
+        }
+        start = cur = reinterpret_cast<const uint8_t*>(block->begin()) + (vaddr - block->vaddr());
+        end = start + (block->size() - (vaddr - block->vaddr()));
+    }
+
+    inline uint64_t vaddr() { return base + (cur - start); }
+    inline bool has(uint64_t size) {
+        if (!errors && static_cast<uint64_t>(end - cur) >= size)
+            return true;
+        errors = true;
+        return false;
+    }
+    inline void skip(uint64_t size) { if (has(size)) cur += size; }
+    inline void seek(uint64_t addr) {
+        if (addr < base || addr - base > static_cast<uint64_t>(end - start)) {
+            errors = true;
+            return;
+        }
+        cur = start + (addr - base);
+    }
+    template<typename T> inline T read() {
+        T value = 0;
+        if (has(sizeof(T))) {
+            memcpy(&value, cur, sizeof(T));
+            cur += sizeof(T);
+        }
+        return value;
+    }
+    inline uint8_t u8() { return read<uint8_t>(); }
+    inline uint64_t uleb() {
+        uint64_t value = 0;
+        int shift = 0;
+        while (has(1)) {
+            uint8_t b = *cur++;
+            if (shift < 64) value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            shift += 7;
+            if (!(b & 0x80)) break;
+        }
+        return value;
+    }
+    inline int64_t sleb() {
+        int64_t value = 0;
+        int shift = 0;
+        uint8_t b = 0;
+        while (has(1)) {
+            b = *cur++;
+            if (shift < 64) value |= static_cast<int64_t>(b & 0x7f) << shift;
+            shift += 7;
+            if (!(b & 0x80)) break;
+        }
+        if (shift < 64 && (b & 0x40))
+            value |= -(static_cast<int64_t>(1) << shift);
+        return value;
+    }
+    uint64_t encoded(uint8_t encoding, uint64_t datarel) {
+        uint64_t here = vaddr();
+        uint64_t value = 0;
+        switch (encoding & 0x0f) {
+            case DW_EH_PE_absptr:
+                value = CoreApi::GetPointSize() == 8 ? read<uint64_t>() : read<uint32_t>();
+                break;
+            case DW_EH_PE_uleb128: value = uleb(); break;
+            case DW_EH_PE_udata2: value = read<uint16_t>(); break;
+            case DW_EH_PE_udata4: value = read<uint32_t>(); break;
+            case DW_EH_PE_udata8: value = read<uint64_t>(); break;
+            case DW_EH_PE_sleb128: value = sleb(); break;
+            case DW_EH_PE_sdata2: value = read<int16_t>(); break;
+            case DW_EH_PE_sdata4: value = read<int32_t>(); break;
+            case DW_EH_PE_sdata8: value = read<int64_t>(); break;
+            default:
+                errors = true;
+                return 0;
+        }
+        switch (encoding & 0x70) {
+            case DW_EH_PE_absptr: break;
+            case DW_EH_PE_pcrel: value += here; break;
+            case DW_EH_PE_datarel: value += datarel; break;
+            default:
+                errors = true;
+                return 0;
+        }
+        if (encoding & DW_EH_PE_indirect) {
+            uint64_t ptr = 0;
+            if (!CoreApi::Read(value, CoreApi::GetPointSize(), reinterpret_cast<uint8_t*>(&ptr), OPT_READ_ALL))
+                errors = true;
+            value = ptr;
+        }
+        return value;
+    }
+    // unit length, 0 for the terminator.
+    uint64_t length() {
+        uint64_t length = read<uint32_t>();
+        if (length == 0xffffffff)
+            length = read<uint64_t>();
+        return length;
+    }
+
+    uint64_t base;
+    const uint8_t* cur;
+    const uint8_t* start;
+    const uint8_t* end;
+    bool errors;
+};
+
+EhFrame::EhFrame(LinkMap* map) : map_(map), hdr_(0), hdr_table_(0), hdr_count_(0) {
+    try {
+        Init();
+    } catch(InvalidAddressException& e) {
+        LOGD("%s no eh_frame_hdr\n", map_->name());
+    }
+}
+
+bool EhFrame::Init() {
+    api::Elfx_Ehdr ehdr(map_->begin());
+    if (!ehdr.IsElf())
+        return false;
+
+    api::Elfx_Phdr phdr(ehdr.Ptr() + ehdr.e_phoff(), ehdr);
+    int phnum = ehdr.e_phnum();
+    for (int index = 0; index < phnum; ++index, phdr.MovePtr(SIZEOF(Elfx_Phdr))) {
+        if (phdr.p_type() == PT_GNU_EH_FRAME) {
+            hdr_ = map_->l_addr() + phdr.p_vaddr();
+            break;
+        }
+    }
+    if (!hdr_)
+        return false;
+
+    /*
+     * u8 version, u8 eh_frame_ptr_enc, u8 fde_count_enc, u8 table_enc,
+     * eh_frame_ptr, fde_count, (initial_loc, fde) * fde_count
+     */
+    EhReader reader(hdr_);
+    uint8_t version = reader.u8();
+    uint8_t eh_frame_ptr_enc = reader.u8();
+    uint8_t fde_count_enc = reader.u8();
+    uint8_t table_enc = reader.u8();
+    if (reader.errors || version != 1)
+        return false;
+
+    uint64_t eh_frame = reader.encoded(eh_frame_ptr_enc, hdr_);
+    if (fde_count_enc != DW_EH_PE_omit && table_enc == (DW_EH_PE_datarel | DW_EH_PE_sdata4)) {
+        uint64_t count = reader.encoded(fde_count_enc, hdr_);
+        if (!reader.errors && reader.has(count * 8)) {
+            hdr_table_ = reader.vaddr();
+            hdr_count_ = count;
+            return true;
+        }
+    }
+    if (reader.errors)
+        return false;
+
+    ScanEhFrame(eh_frame);
+    return fdes_.size();
+}
+
+void EhFrame::ScanEhFrame(uint64_t eh_frame) {
+    EhReader reader(eh_frame);
+    while (!reader.errors) {
+        uint64_t entry = reader.vaddr();
+        uint64_t length = reader.length();
+        if (!length || reader.errors)
+            break;
+        uint64_t next = reader.vaddr() + length;
+        uint32_t id = reader.read<uint32_t>();
+        if (id) {
+            Fde fde;
+            if (ReadFde(entry, &fde))
+                fdes_.push_back({fde.pc_begin, entry});
+        }
+        reader.seek(next);
+    }
+    std::sort(fdes_.begin(), fdes_.end());
+    LOGD("%s scan eh_frame fdes(%zu)\n", map_->name(), fdes_.size());
+}
+
+const EhFrame::Cie* EhFrame::ReadCie(uint64_t vaddr) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = cies_.find(vaddr);
+        if (it != cies_.end())
+            return &it->second;
+    }
+
+    EhReader reader(vaddr);
+    uint64_t length = reader.length();
+    uint64_t end = reader.vaddr() + length;
+    uint32_t id = reader.read<uint32_t>();
+    uint8_t version = reader.u8();
+    if (reader.errors || !length || id || (version != 1 && version != 3 && version != 4))
+        return nullptr;
+
+    std::string augmentation;
+    for (uint8_t c = reader.u8(); c && !reader.errors; c = reader.u8())
+        augmentation.push_back(c);
+    if (version == 4)
+        reader.skip(2); // address_size, segment_size
+
+    Cie cie;
+    memset(&cie, 0x0, sizeof(Cie));
+    cie.fde_encoding = DW_EH_PE_absptr;
+    cie.end = end;
+    if (augmentation.find("eh") == 0)
+        reader.skip(CoreApi::GetPointSize());
+    cie.code_align = reader.uleb();
+    cie.data_align = reader.sleb();
+    cie.ra = version == 1 ? reader.u8() : reader.uleb();
+
+    if (augmentation.length() && augmentation[0] == 'z') {
+        cie.augmentation = true;
+        uint64_t size = reader.uleb();
+        uint64_t instructions = reader.vaddr() + size;
+        for (size_t i = 1; i < augmentation.length() && !reader.errors; ++i) {
+            switch (augmentation[i]) {
+                case 'L': reader.u8(); break;
+                case 'P': reader.encoded(reader.u8(), hdr_); break;
+                case 'R': cie.fde_encoding = reader.u8(); break;
+                default: break; // 'S', 'B', 'G' carry no data
+            }
+        }
+        reader.seek(instructions);
+    }
+    cie.instructions = reader.vaddr();
+    if (reader.errors || cie.instructions > end)
+        return nullptr;
+
+    std::lock_guard<std::mutex> guard(lock_);
+    return &cies_.emplace(vaddr, cie).first->second;
+}
+
+bool EhFrame::ReadFde(uint64_t vaddr, Fde* fde) {
+    EhReader reader(vaddr);
+    uint64_t length = reader.length();
+    uint64_t end = reader.vaddr() + length;
+    uint64_t id_addr = reader.vaddr();
+    uint32_t id = reader.read<uint32_t>();
+    if (reader.errors || !length || !id)
+        return false;
+
+    const Cie* cie = ReadCie(id_addr - id);
+    if (!cie)
+        return false;
+
+    fde->pc_begin = reader.encoded(cie->fde_encoding, hdr_);
+    // absolute pointers are link time addresses.
+    if (!(cie->fde_encoding & 0x70) && fde->pc_begin < map_->l_addr())
+        fde->pc_begin += map_->l_addr();
+    fde->pc_end = fde->pc_begin + reader.encoded(cie->fde_encoding & 0x0f, hdr_);
+    if (cie->augmentation)
+        reader.skip(reader.uleb());
+    fde->instructions = reader.vaddr();
+    fde->end = end;
+    fde->cie = cie;
+    return !reader.errors && fde->instructions <= end;
+}
+
+bool EhFrame::FindFde(uint64_t pc, Fde* fde) {
+    uint64_t entry = 0;
+    if (hdr_count_) {
+        EhReader reader(hdr_table_);
+        if (!reader.has(hdr_count_ * 8))
+            return false;
+        const uint8_t* table = reader.cur;
+        auto loc = [&](uint64_t index) -> uint64_t {
+            int32_t value;
+            memcpy(&value, table + index * 8, sizeof(value));
+            return hdr_ + value;
+        };
+        // last entry whose initial_loc <= pc
+        uint64_t lo = 0, hi = hdr_count_;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (loc(mid) <= pc) lo = mid + 1;
+            else hi = mid;
+        }
+        if (!lo)
+            return false;
+        int32_t value;
+        memcpy(&value, table + (lo - 1) * 8 + 4, sizeof(value));
+        entry = hdr_ + value;
+    } else {
+        auto it = std::upper_bound(fdes_.begin(), fdes_.end(), FdeEntry{pc, 0});
+        if (it == fdes_.begin())
+            return false;
+        entry = (it - 1)->fde;
+    }
+    return ReadFde(entry, fde) && pc >= fde->pc_begin && pc < fde->pc_end;
+}
+
+bool EhFrame::Execute(uint64_t begin, uint64_t end, const Cie& cie, uint64_t loc, uint64_t pc,
+                      const Row* initial, Row* row) {
+    std::vector<Row> stack;
+    EhReader reader(begin);
+    auto rule = [&](uint64_t reg, RuleType type, int64_t value) {
+        if (reg < kMaxRegs) row->regs[reg] = {type, value};
+    };
+
+    while (!reader.errors && reader.vaddr() < end) {
+        uint8_t op = reader.u8();
+        uint8_t operand = op & 0x3f;
+        switch (op & 0xc0) {
+            case DW_CFA_advance_loc:
+                loc += operand * cie.code_align;
+                if (loc > pc) return true;
+                continue;
+            case DW_CFA_offset:
+                rule(operand, RULE_OFFSET, reader.uleb() * cie.data_align);
+                continue;
+            case DW_CFA_restore:
+                if (initial && operand < kMaxRegs) row->regs[operand] = initial->regs[operand];
+                continue;
+        }
+
+        switch (op) {
+            case DW_CFA_nop:
+            case DW_CFA_AARCH64_negate_ra_state:
+                break;
+            case DW_CFA_set_loc:
+                loc = reader.encoded(cie.fde_encoding, hdr_);
+                if (loc > pc) return true;
+                break;
+            case DW_CFA_advance_loc1:
+                loc += reader.u8() * cie.code_align;
+                if (loc > pc) return true;
+                break;
+            case DW_CFA_advance_loc2:
+                loc += reader.read<uint16_t>() * cie.code_align;
+                if (loc > pc) return true;
+                break;
+            case DW_CFA_advance_loc4:
+                loc += reader.read<uint32_t>() * cie.code_align;
+                if (loc > pc) return true;
+                break;
+            case DW_CFA_offset_extended: {
+                uint64_t reg = reader.uleb();
+                rule(reg, RULE_OFFSET, reader.uleb() * cie.data_align);
+            } break;
+            case DW_CFA_restore_extended: {
+                uint64_t reg = reader.uleb();
+                if (initial && reg < kMaxRegs) row->regs[reg] = initial->regs[reg];
+            } break;
+            case DW_CFA_undefined:
+                rule(reader.uleb(), RULE_UNDEFINED, 0);
+                break;
+            case DW_CFA_same_value:
+                rule(reader.uleb(), RULE_SAME, 0);
+                break;
+            case DW_CFA_register: {
+                uint64_t reg = reader.uleb();
+                rule(reg, RULE_REGISTER, reader.uleb());
+            } break;
+            case DW_CFA_remember_state:
+                stack.push_back(*row);
+                break;
+            case DW_CFA_restore_state:
+                if (stack.empty()) return false;
+                *row = stack.back();
+                stack.pop_back();
+                break;
+            case DW_CFA_def_cfa:
+                row->cfa_reg = reader.uleb();
+                row->cfa_offset = reader.uleb();
+                row->cfa_valid = true;
+                break;
+            case DW_CFA_def_cfa_register:
+                row->cfa_reg = reader.uleb();
+                break;
+            case DW_CFA_def_cfa_offset:
+                row->cfa_offset = reader.uleb();
+                break;
+            case DW_CFA_def_cfa_expression:
+                reader.skip(reader.uleb());
+                row->cfa_valid = false;
+                break;
+            case DW_CFA_expression:
+            case DW_CFA_val_expression: {
+                uint64_t reg = reader.uleb();
+                reader.skip(reader.uleb());
+                rule(reg, RULE_UNSUPPORTED, 0);
+            } break;
+            case DW_CFA_offset_extended_sf: {
+                uint64_t reg = reader.uleb();
+                rule(reg, RULE_OFFSET, reader.sleb() * cie.data_align);
+            } break;
+            case DW_CFA_def_cfa_sf:
+                row->cfa_reg = reader.uleb();
+                row->cfa_offset = reader.sleb() * cie.data_align;
+                row->cfa_valid = true;
+                break;
+            case DW_CFA_def_cfa_offset_sf:
+                row->cfa_offset = reader.sleb() * cie.data_align;
+                break;
+            case DW_CFA_val_offset: {
+                uint64_t reg = reader.uleb();
+                rule(reg, RULE_VAL_OFFSET, reader.uleb() * cie.data_align);
+            } break;
+            case DW_CFA_val_offset_sf: {
+                uint64_t reg = reader.uleb();
+                rule(reg, RULE_VAL_OFFSET, reader.sleb() * cie.data_align);
+            } break;
+            case DW_CFA_GNU_args_size:
+                reader.uleb();
+                break;
+            case DW_CFA_GNU_negative_offset_extended: {
+                uint64_t reg = reader.uleb();
+                rule(reg, RULE_OFFSET, -static_cast<int64_t>(reader.uleb()) * cie.data_align);
+            } break;
+            default:
+                LOGD("%s unknown cfa op 0x%x\n", map_->name(), op);
+                return false;
+        }
+    }
+    return !reader.errors;
+}
+
+bool EhFrame::FindRow(uint64_t pc, Row* row) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = rows_.find(pc);
+        if (it != rows_.end()) {
+            *row = it->second;
+            return row->cfa_valid;
+        }
+    }
+
+    memset(row, 0x0, sizeof(Row));
+    if (!DecodeRow(pc, row))
+        row->cfa_valid = false;
+
+    std::lock_guard<std::mutex> guard(lock_);
+    if (rows_.size() >= kMaxRows)
+        rows_.clear();
+    rows_[pc] = *row;
+    return row->cfa_valid;
+}
+
+bool EhFrame::DecodeRow(uint64_t pc, Row* row) {
+    Fde fde;
+    if (!FindFde(pc, &fde))
+        return false;
+
+    const Cie& cie = *fde.cie;
+    Row initial;
+    memset(&initial, 0x0, sizeof(Row));
+    if (!Execute(cie.instructions, cie.end, cie, fde.pc_begin, UINT64_MAX, nullptr, &initial))
+        return false;
+
+    *row = initial;
+    if (!Execute(fde.instructions, fde.end, cie, fde.pc_begin, pc, &initial, row)
+            || cie.ra >= kMaxRegs)
+        return false;
+
+    row->ra = cie.ra;
+    return true;
+}
+
+EhFrame* EhFrame::Find(uint64_t pc) {
+    LoadBlock* block = CoreApi::FindLoadBlock(pc, false);
+    if (!block)
+        return nullptr;
+    LinkMap* map = CoreApi::FindLinkMap(pc, block);
+    return map ? map->GetEhFrame() : nullptr;
+}
+
+int EhFrame::Step(int sp, Regs& regs) {
+    Row row;
+    if (!FindRow(regs.pc, &row) || !regs.has(row.cfa_reg))
+        return STEP_FAIL;
+
+    uint32_t ra = row.ra;
+    uint64_t cfa = regs.value[row.cfa_reg] + row.cfa_offset;
+    Regs caller = regs;
+    for (int reg = 0; reg < kMaxRegs; ++reg) {
+        const Rule& rule = row.regs[reg];
+        switch (rule.type) {
+            case RULE_UNSPEC:
+            case RULE_SAME:
+                break;
+            case RULE_UNDEFINED:
+            case RULE_UNSUPPORTED:
+                caller.valid &= ~(1ULL << reg);
+                break;
+            case RULE_OFFSET: {
+                uint64_t value = 0;
+                if (!CoreApi::Read(cfa + rule.value, CoreApi::GetPointSize(),
+                                   reinterpret_cast<uint8_t*>(&value), OPT_READ_ALL))
+                    return STEP_FAIL;
+                caller.set(reg, value);
+            } break;
+            case RULE_VAL_OFFSET:
+                caller.set(reg, cfa + rule.value);
+                break;
+            case RULE_REGISTER:
+                if (regs.has(rule.value)) caller.set(reg, regs.value[rule.value]);
+                else caller.valid &= ~(1ULL << reg);
+                break;
+        }
+    }
+
+    // undefined return address marks the outermost frame.
+    if (!caller.has(ra))
+        return STEP_END;
+    caller.set(sp, cfa);
+    caller.pc = caller.value[ra];
+    regs = caller;
+    return STEP_OK;
+}
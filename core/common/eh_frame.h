@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_COMMON_EH_FRAME_H_
+#define CORE_COMMON_EH_FRAME_H_
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+class LinkMap;
+
+/*
+ * Call frame information (.eh_frame) of one LinkMap.
+ *
+ *   pc --> FDE   .eh_frame_hdr table, or a sorted scan of .eh_frame
+ *      --> Row   CIE + FDE instructions run up to pc, cached by pc
+ *      --> cfa = reg + offset, caller regs are saved at cfa + N
+ *
+ * Registers are DWARF numbers, the caller's sp is the cfa and its pc is
+ * the return address column. Expression rules are not evaluated, such
+ * frames fail the step and the unwinder falls back to frame pointers.
+ * Step may run from several threads, the CIE and row caches are locked.
+ */
+class EhFrame {
+public:
+    static constexpr int kMaxRegs = 33;
+    static constexpr uint64_t kMaxRows = 16384;
+
+    struct Regs {
+        uint64_t value[kMaxRegs];
+        uint64_t valid;     // bit per register
+        uint64_t pc;        // lookup pc, return address after Step
+
+        Regs() : valid(0), pc(0) {}
+        inline bool has(int reg) const { return reg >= 0 && reg < kMaxRegs && ((valid >> reg) & 1); }
+        inline void set(int reg, uint64_t v) {
+            if (reg < 0 || reg >= kMaxRegs) return;
+            value[reg] = v;
+            valid |= 1ULL << reg;
+        }
+    };
+
+    static constexpr int STEP_FAIL = 0;    // no usable rule for regs.pc
+    static constexpr int STEP_END = 1;     // return address undefined, outermost frame
+    static constexpr int STEP_OK = 2;
+
+    EhFrame(LinkMap* map);
+    // eh_frame of the LinkMap holding pc, null if it has none.
+    static EhFrame* Find(uint64_t pc);
+    inline bool IsValid() { return hdr_count_ || fdes_.size(); }
+    // regs of the frame at regs.pc become its caller's.
+    int Step(int sp, Regs& regs);
+private:
+    enum RuleType : uint8_t {
+        RULE_UNSPEC = 0,    // unspecified, keeps the callee value
+        RULE_UNDEFINED,
+        RULE_SAME,
+        RULE_OFFSET,        // saved at cfa + value
+        RULE_VAL_OFFSET,    // is cfa + value
+        RULE_REGISTER,      // in register value
+        RULE_UNSUPPORTED,
+    };
+
+    struct Rule {
+        RuleType type;
+        int64_t value;
+    };
+
+    struct Row {
+        uint32_t ra;            // return address column
+        uint32_t cfa_reg;
+        int64_t cfa_offset;
+        bool cfa_valid;
+        Rule regs[kMaxRegs];
+    };
+
+    struct Cie {
+        uint64_t code_align;
+        int64_t data_align;
+        uint32_t ra;
+        uint8_t fde_encoding;
+        bool augmentation;      // 'z', FDEs carry augmentation data
+        uint64_t instructions;
+        uint64_t end;
+    };
+
+    struct Fde {
+        uint64_t pc_begin;
+        uint64_t pc_end;
+        uint64_t instructions;
+        uint64_t end;
+        const Cie* cie;
+    };
+
+    struct FdeEntry {
+        uint64_t pc;
+        uint64_t fde;
+        inline bool operator<(const FdeEntry& other) const { return pc < other.pc; }
+    };
+
+    bool Init();
+    void ScanEhFrame(uint64_t eh_frame);
+    const Cie* ReadCie(uint64_t vaddr);
+    bool ReadFde(uint64_t vaddr, Fde* fde);
+    bool FindFde(uint64_t pc, Fde* fde);
+    bool Execute(uint64_t begin, uint64_t end, const Cie& cie, uint64_t loc, uint64_t pc,
+                 const Row* initial, Row* row);
+    bool FindRow(uint64_t pc, Row* row);
+    bool DecodeRow(uint64_t pc, Row* row);
+
+    LinkMap* map_;
+    uint64_t hdr_;
+    uint64_t hdr_table_;
+    uint64_t hdr_count_;
+    std::vector<FdeEntry> fdes_;
+    std::unordered_map<uint64_t, Cie> cies_;
+    std::unordered_map<uint64_t, Row> rows_;
+    std::mutex lock_;
+};
+
+#endif // CORE_COMMON_EH_FRAME_H_
@@ -23,8 +23,8 @@
 #include "common/exception.h"
 #include "common/load_block.h"
 #include "common/elf.h"
+#include "api/symbol_cache.h"
 #include <linux/elf.h>
-#include "llvm/Demangle/Demangle.h"
 
 struct LinkMap_OffsetTable __LinkMap_offset__;
 struct LinkMap_SizeTable __LinkMap_size__;
@@ -108,23 +108,16 @@ void LinkMap::NiceMethod(uint64_t pc, NiceSymbol& symbol) {
         if (CoreApi::GetMachine() == EM_ARM)
             nice_offset &= (CoreApi::GetPointMask() - 1);
         nice_size = entry.size;
-        symbol.SetNiceMethod(entry.symbol.data(), nice_offset, nice_size);
+        symbol.SetNiceMethod(this, entry.symbol.data(), nice_offset, nice_size);
     }
 }
 
 SymbolEntry LinkMap::DlSymEntry(const char* symbol) {
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash>& symbols = GetCurrentSymbols();
-    const auto& it = std::find_if(symbols.begin(), symbols.end(),
-            [&](const SymbolEntry& entry) {
-                return entry.symbol == symbol;
-            });
-    if (it != symbols.end())
-        return *it;
-    return SymbolEntry::Invalid();
+    return GetCurrentSymbols().Find(symbol);
 }
 
 SymbolEntry LinkMap::DlRegionSymEntry(uint64_t addr) {
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash>& symbols = GetCurrentSymbols();
+    SymbolTable& symbols = GetCurrentSymbols();
     if (!symbols.size())
         return SymbolEntry::Invalid();
 
@@ -132,42 +125,42 @@ SymbolEntry LinkMap::DlRegionSymEntry(uint64_t addr) {
     if (cloc_addr <= l_addr())
         return SymbolEntry::Invalid();
 
-    uint64_t cloc_offset = cloc_addr - l_addr();
-    const auto& it = std::find_if(symbols.begin(), symbols.end(),
-            [&](const SymbolEntry& entry) {
-                uint64_t offset = entry.offset;
-                if (CoreApi::GetMachine() == EM_ARM)
-                    offset &= (CoreApi::GetPointMask() - 1);
-
-                if (offset > cloc_offset)
-                    return false;
-
-                if (cloc_offset < offset + entry.size)
-                    return true;
+    return symbols.FindRegion(cloc_addr - l_addr());
+}
 
-                return false;
-            });
-    if (it != symbols.end())
-        return *it;
-    return SymbolEntry::Invalid();
+EhFrame* LinkMap::GetEhFrame() {
+    if (!eh_frame)
+        eh_frame = std::make_unique<EhFrame>(this);
+    return eh_frame->IsValid() ? eh_frame.get() : nullptr;
 }
 
 void LinkMap::ReadSymbols() {
     LoadBlock* load = block();
+    // text may only now be mapped in from sysroot.
+    eh_frame.reset();
     if (load && load->isMmapBlock()) {
         ElfHeader* header = reinterpret_cast<ElfHeader*>(load->begin());
         if (!header->CheckLibrary(load->name().c_str()))
             return;
 
-        std::unordered_set<SymbolEntry, SymbolEntry::Hash>& symbols = load->GetSymbols();
+        SymbolTable& symbols = load->GetSymbols();
         symbols.clear(); // clear prev symbols
-        if (CoreApi::Bits() == 64) {
-            lp64::Core::readsym64(this);
-        } else {
-            lp32::Core::readsym32(this);
+        std::string dwarf_index;
+        bool cached = SymbolCache::Load(load, dwarf_index);
+        if (!cached) {
+            if (CoreApi::Bits() == 64) {
+                lp64::Core::readsym64(this);
+            } else {
+                lp32::Core::readsym32(this);
+            }
         }
+        if (!dwarf_loader)
+            dwarf_loader = dwarf::DwarfLoader::Load(load->name().c_str(), dwarf_index);
+        // a truncated file reads nothing, don't pin that to its build-id.
+        if (!cached && symbols.size())
+            SymbolCache::Save(load, dwarf_loader.get());
         if (symbols.size()) LOGI(ANSI_COLOR_GREEN "Read symbols[%ld] (%s)\n" ANSI_COLOR_RESET, symbols.size(), name());
-        dwarf_loader = dwarf::DwarfLoader::Load(load->name().c_str());
+        CoreApi::CleanSymbols();
     }
 }
 
@@ -177,10 +170,13 @@ void LinkMap::ReadDynsyms() {
         api::Elf::ReadSymbols(this);
     } catch(InvalidAddressException& e) {
     }
+    dynsyms.Build(SymbolMask());
     if (dynsyms.size()) LOGD("Read dynsyms[%ld] (%s)\n", dynsyms.size(), name());
+    // calibration reads again, drop names and offsets of the old table.
+    CoreApi::CleanSymbols();
 }
 
-std::unordered_set<SymbolEntry, SymbolEntry::Hash>& LinkMap::GetCurrentSymbols() {
+SymbolTable& LinkMap::GetCurrentSymbols() {
     LoadBlock* load = block();
     if (load && load->isMmapBlock()) {
         return load->GetSymbols();
@@ -189,17 +185,15 @@ std::unordered_set<SymbolEntry, SymbolEntry::Hash>& LinkMap::GetCurrentSymbols()
     }
 }
 
-std::string& LinkMap::NiceSymbol::GetMethod() {
-    if (method.length() == 0) {
-        char* demangled_name = llvm::itaniumDemangle(symbol.data());
-        if (!demangled_name)
-            demangled_name = llvm::rustDemangle(symbol.data());
-        if (demangled_name) {
-            method = demangled_name;
-            std::free(demangled_name);
-        } else {
-            method = symbol;
-        }
-    }
-    return method;
+uint64_t LinkMap::SymbolMask() {
+    // thumb symbols keep bit 0 in st_value
+    if (CoreApi::GetMachine() == EM_ARM)
+        return CoreApi::GetPointMask() - 1;
+    return -1;
+}
+
+std::string_view LinkMap::NiceSymbol::GetMethod() {
+    if (!method.length() && !storage.length() && symbol.length())
+        method = CoreApi::Demangle(map, off, symbol.c_str(), storage);
+    return method.length() ? method : std::string_view(storage);
 }
@@ -19,8 +19,11 @@
 
 #include "api/memory_ref.h"
 #include "api/dwarf.h"
+#include "common/symbol_table.h"
+#include "common/eh_frame.h"
 #include <string>
-#include <unordered_set>
+#include <string_view>
+#include <memory>
 
 struct LinkMap_OffsetTable {
     uint32_t l_addr;
@@ -55,21 +58,24 @@ public:
 
     class NiceSymbol {
     public:
-        NiceSymbol() : off(0), size(0) {}
-        void SetNiceMethod(const char* sym, uint64_t o, uint64_t s) {
+        NiceSymbol() : map(nullptr), off(0), size(0) {}
+        void SetNiceMethod(LinkMap* m, const char* sym, uint64_t o, uint64_t s) {
+            map = m;
             sym ? symbol = sym : "";
             off = o;
             size = s;
         }
         std::string& GetSymbol() { return symbol; }
-        std::string& GetMethod();
+        std::string_view GetMethod();
         uint64_t GetOffset() { return off; }
         uint64_t GetSize() { return size; }
         bool IsValid() { return off && size; }
         static NiceSymbol Invalid() { return NiceSymbol(); }
     private:
+        LinkMap* map;
         std::string symbol;
-        std::string method;
+        std::string_view method;    // in the shared demangle cache
+        std::string storage;        // the cache is full
         uint64_t off;
         uint64_t size;
     };
@@ -81,14 +87,17 @@ public:
     inline uint64_t DlSym(const char* symbol) { return DlSymEntry(symbol).offset; }
     api::MemoryRef& GetAddrCache();
     api::MemoryRef& GetNameCache();
-    inline std::unordered_set<SymbolEntry, SymbolEntry::Hash>& GetDynsyms() { return dynsyms; }
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash>& GetCurrentSymbols();
+    inline SymbolTable& GetDynsyms() { return dynsyms; }
+    SymbolTable& GetCurrentSymbols();
+    static uint64_t SymbolMask();
     std::unique_ptr<dwarf::DwarfLoader>& GetDwarfLoader() { return dwarf_loader; }
+    EhFrame* GetEhFrame();
 private:
     api::MemoryRef addr_cache = 0x0;
     api::MemoryRef name_cache = 0x0;
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash> dynsyms;
+    SymbolTable dynsyms;
     std::unique_ptr<dwarf::DwarfLoader> dwarf_loader;
+    std::unique_ptr<EhFrame> eh_frame;
 };
 
 #endif  // CORE_COMMON_LINKMAP_H_
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "api/core.h"
+#include "common/link_map_index.h"
+#include "common/link_map.h"
+#include <algorithm>
+#include <limits>
+
+void LinkMapIndex::Build(std::vector<LinkMap*>& maps) {
+    Invalidate();
+    links = maps;
+
+    for (uint32_t i = 0; i < links.size(); ++i) {
+        LinkMap* link = links[i];
+        names.emplace(link->name(), i);
+
+        uint64_t begin = link->begin();
+        if (!begin)
+            continue;
+
+        // pc < l_ld, or pc <= end of the dynamic block.
+        uint64_t end = link->l_ld();
+        LoadBlock* ld_block = CoreApi::FindLoadBlock(link->l_ld(), false);
+        if (ld_block)
+            end = std::max(end, ld_block->vaddr() + ld_block->memsz() + 1);
+        if (end > begin)
+            ranges.push_back({begin, end, i});
+    }
+    std::stable_sort(ranges.begin(), ranges.end());
+
+    max_ends.resize(ranges.size());
+    uint64_t max_end = 0;
+    for (int i = 0; i < ranges.size(); ++i) {
+        if (ranges[i].end > max_end) max_end = ranges[i].end;
+        max_ends[i] = max_end;
+    }
+    ready = true;
+}
+
+void LinkMapIndex::Invalidate() {
+    ready = false;
+    links.clear();
+    ranges.clear();
+    max_ends.clear();
+    names.clear();
+}
+
+LinkMap* LinkMapIndex::Find(uint64_t vaddr, const std::string& filename) {
+    uint32_t best = std::numeric_limits<uint32_t>::max();
+    if (filename.length()) {
+        const auto& it = names.find(filename);
+        if (it != names.end())
+            best = it->second;
+    }
+
+    const auto& it = std::upper_bound(ranges.begin(), ranges.end(), vaddr,
+            [](uint64_t value, const Range& range) { return value < range.begin; });
+    int index = (it - ranges.begin()) - 1;
+    for (; index >= 0 && max_ends[index] > vaddr; --index) {
+        const Range& range = ranges[index];
+        if (vaddr < range.end && range.map < best)
+            best = range.map;
+    }
+
+    return best < links.size() ? links[best] : nullptr;
+}
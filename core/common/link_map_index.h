@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_COMMON_LINK_MAP_INDEX_H_
+#define CORE_COMMON_LINK_MAP_INDEX_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class LinkMap;
+
+/*
+ * Address -> LinkMap for pcs whose load block has no bound handle.
+ *
+ *   link i:  [begin ................ l_ld | dynamic block end]
+ *
+ * ranges are sorted by begin, max_ends[i] is the largest end of
+ * ranges[0..i] so overlapped ranges are still found by walking back
+ * while a range can cover the pc. Between all matches, and a link whose
+ * name equals the block file, the earliest link in link order wins.
+ */
+class LinkMapIndex {
+public:
+    LinkMapIndex() : ready(false) {}
+
+    void Build(std::vector<LinkMap*>& maps);
+    void Invalidate();
+    inline bool IsReady() { return ready; }
+    LinkMap* Find(uint64_t vaddr, const std::string& filename);
+private:
+    struct Range {
+        uint64_t begin;
+        uint64_t end;     // [begin, end)
+        uint32_t map;     // index in link order
+
+        inline bool operator<(const Range& other) const {
+            return begin < other.begin;
+        }
+    };
+
+    bool ready;
+    std::vector<LinkMap*> links;
+    std::vector<Range> ranges;
+    std::vector<uint64_t> max_ends;
+    std::unordered_map<std::string, uint32_t> names;
+};
+
+#endif // CORE_COMMON_LINK_MAP_INDEX_H_
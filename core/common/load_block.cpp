@@ -53,6 +53,7 @@ void LoadBlock::setMmapFile(const char* file, uint64_t offset) {
                    reinterpret_cast<uint64_t *>(map->data()),
                    map->realSize());
         mMmap = std::move(map);
+        CoreApi::CleanSymbols();
     }
 }
 
@@ -87,6 +88,7 @@ void LoadBlock::removeMmap() {
         LOGI("Remove mmap [%" PRIx64 ", %" PRIx64 ") %s\n", vaddr(), vaddr() + memsz(), name().c_str());
         mSymbols.clear();
         mMmap.reset();
+        CoreApi::CleanSymbols();
     }
 }
 
@@ -18,13 +18,12 @@
 #define CORE_COMMON_LOAD_BLOCK_H_
 
 #include "common/block.h"
-#include "common/syment.h"
+#include "common/symbol_table.h"
 #include "base/memory_map.h"
 #include "base/macros.h"
 #include "base/utils.h"
 #include <string>
 #include <memory>
-#include <unordered_set>
 
 class LinkMap;
 
@@ -131,7 +130,7 @@ public:
     inline uint64_t PointMask() { return mPointMask; }
     inline uint64_t GetMmapOffset() { return mMmap->offset(); }
     inline void setMmapMemoryMap(std::unique_ptr<MemoryMap>& map) { mMmap = std::move(map); }
-    inline std::unordered_set<SymbolEntry, SymbolEntry::Hash>& GetSymbols() { return mSymbols; }
+    inline SymbolTable& GetSymbols() { return mSymbols; }
     bool CheckCanMmap(uint64_t header);
     uint32_t GetCRC32(int opt);
     void bind(LinkMap* map) { mLinkMap = map; }
@@ -153,7 +152,7 @@ private:
     uint64_t mPageOffset;
     LinkMap* mLinkMap;
     std::unique_ptr<MemoryMap> mMmap;
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash> mSymbols;
+    SymbolTable mSymbols;
 };
 
 #endif  // CORE_COMMON_LOAD_BLOCK_H_
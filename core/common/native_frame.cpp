@@ -28,30 +28,7 @@ NativeFrame::NativeFrame(uint64_t fp, uint64_t sp, uint64_t pc)
 
 void NativeFrame::Decode() {
     LoadBlock* block = CoreApi::FindLoadBlock(frame_pc, false);
-
-    auto callback = [&](LinkMap* link) -> bool {
-        // FOR TEST
-        uint64_t va_pc = frame_pc & CoreApi::GetVabitsMask();
-        LoadBlock* ld_block = CoreApi::FindLoadBlock(link->l_ld(), false);
-        if (block && block->filename().length()
-                && block->filename() == link->name()) {
-            map = link;
-            return true;
-        } else if (link->begin() && va_pc >= link->begin()
-                && (va_pc < link->l_ld() ||
-                    (ld_block ? (va_pc <= ld_block->vaddr() + ld_block->memsz()) : false))) {
-            map = link;
-            return true;
-
-        }
-        return false;
-    };
-
-    if (block && block->handle()) {
-        map = block->handle();
-    } else {
-        CoreApi::ForeachLinkMap(callback);
-    }
+    map = CoreApi::FindLinkMap(frame_pc, block);
     if (map) map->NiceMethod(frame_pc, frame_symbol);
 }
 
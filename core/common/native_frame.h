@@ -26,7 +26,7 @@ public:
     uint64_t GetFrameFp() { return frame_fp; }
     void SetFramePc(uint64_t pc);
     uint64_t GetFramePc() { return frame_pc; }
-    std::string& GetMethodName() { return frame_symbol.GetMethod(); }
+    std::string_view GetMethodName() { return frame_symbol.GetMethod(); }
     std::string& GetMethodSymbol() { return frame_symbol.GetSymbol(); }
     LinkMap* GetLinkMap() { return map; }
     uint64_t GetMethodOffset();
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/symbol_interner.h"
+#include "common/link_map.h"
+#include <string.h>
+#include <algorithm>
+#include <functional>
+
+void SymbolInterner::Invalidate() {
+    indexed = 0;
+    count = 0;
+    slots.clear();
+    pool.clear();
+    pool_cur = nullptr;
+    pool_left = 0;
+}
+
+void SymbolInterner::clear() {
+    Invalidate();
+    maps.clear();
+}
+
+LinkMap* SymbolInterner::Find(const char* symbol, uint64_t* offset) {
+    Update();
+    if (!count)
+        return nullptr;
+
+    std::string_view name(symbol);
+    uint64_t hash = std::hash<std::string_view>()(name);
+    uint64_t mask = slots.size() - 1;
+    for (uint64_t i = hash & mask; slots[i].name; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.hash == hash && slot.length == name.length()
+                && !memcmp(slot.name, name.data(), name.length())) {
+            *offset = slot.offset;
+            return maps[slot.map];
+        }
+    }
+    return nullptr;
+}
+
+void SymbolInterner::Update() {
+    for (; indexed < maps.size(); ++indexed) {
+        for (const auto& entry : maps[indexed]->GetCurrentSymbols()) {
+            // undefined imports carry no address, the next map may define them.
+            if (!entry.offset || !entry.symbol.length())
+                continue;
+            Insert(entry.symbol, indexed, entry.offset);
+        }
+    }
+}
+
+void SymbolInterner::Insert(std::string_view name, uint32_t map, uint64_t offset) {
+    if ((count + 1) * 10 > slots.size() * 7)
+        Grow();
+
+    uint64_t hash = std::hash<std::string_view>()(name);
+    uint64_t mask = slots.size() - 1;
+    uint64_t i = hash & mask;
+    for (; slots[i].name; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.hash == hash && slot.length == name.length()
+                && !memcmp(slot.name, name.data(), name.length())) {
+            // same name twice in one image, keep the lowest like SymbolTable::Find.
+            if (slot.map == map && offset < slot.offset)
+                slot.offset = offset;
+            return;
+        }
+    }
+    slots[i] = { hash, Intern(name), static_cast<uint32_t>(name.length()), map, offset };
+    count++;
+}
+
+void SymbolInterner::Grow() {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.resize(old.size() ? old.size() * 2 : kMinCapacity);
+
+    uint64_t mask = slots.size() - 1;
+    for (const auto& slot : old) {
+        if (!slot.name)
+            continue;
+        uint64_t i = slot.hash & mask;
+        while (slots[i].name) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+const char* SymbolInterner::Intern(std::string_view name) {
+    uint64_t length = name.length() + 1;
+    if (length > pool_left) {
+        uint64_t size = std::max(kPoolChunkSize, length);
+        pool.emplace_back(new char[size]);
+        pool_cur = pool.back().get();
+        pool_left = size;
+    }
+    char* str = pool_cur;
+    memcpy(str, name.data(), name.length());
+    str[name.length()] = '\0';
+    pool_cur += length;
+    pool_left -= length;
+    return str;
+}
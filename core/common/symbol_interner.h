@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_COMMON_SYMBOL_INTERNER_H_
+#define CORE_COMMON_SYMBOL_INTERNER_H_
+
+#include <stdint.h>
+#include <string_view>
+#include <memory>
+#include <vector>
+
+class LinkMap;
+
+/*
+ * Process wide name -> (LinkMap, offset), answers CoreApi::DlSym with one
+ * probe instead of one lookup per library.
+ *
+ *   Add(map0) Add(map1) ...   maps in link order, read on the next Find
+ *   Invalidate()              some map changed its symbols, re-read all
+ *
+ * Names are copied into a chunked pool, slots use open addressing with
+ * linear probing. A name keeps the first map in link order that defines
+ * it, same as walking the link maps one by one.
+ */
+class SymbolInterner {
+public:
+    static constexpr uint64_t kPoolChunkSize = 1024 * 1024;
+    static constexpr uint64_t kMinCapacity = 1024;
+
+    SymbolInterner() : indexed(0), count(0), pool_cur(nullptr), pool_left(0) {}
+
+    void Add(LinkMap* map) { maps.push_back(map); }
+    void Invalidate();
+    void clear();
+    // nullptr if no link map defines symbol.
+    LinkMap* Find(const char* symbol, uint64_t* offset);
+private:
+    struct Slot {
+        uint64_t hash;
+        const char* name;
+        uint32_t length;
+        uint32_t map;     // index of maps, lower wins
+        uint64_t offset;
+    };
+
+    void Update();
+    void Insert(std::string_view name, uint32_t map, uint64_t offset);
+    void Grow();
+    const char* Intern(std::string_view name);
+
+    std::vector<LinkMap*> maps;
+    uint32_t indexed;
+    uint64_t count;
+    std::vector<Slot> slots;
+    std::vector<std::unique_ptr<char[]>> pool;
+    char* pool_cur;
+    uint64_t pool_left;
+};
+
+#endif // CORE_COMMON_SYMBOL_INTERNER_H_
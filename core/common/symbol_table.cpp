@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/symbol_table.h"
+#include <string.h>
+#include <algorithm>
+#include <functional>
+
+uint16_t SymbolTable::AddStrtab(const char* base) {
+    strtabs.push_back(base);
+    return strtabs.size() - 1;
+}
+
+void SymbolTable::Insert(const SymbolEntry& entry) {
+    uint64_t length = entry.symbol.length() + 1;
+    if (!pool_size || pool_used + length > pool_size) {
+        pool_size = std::max(kPoolChunkSize, length);
+        pool_used = 0;
+        pool.emplace_back(new char[pool_size]);
+        pool_strtab = AddStrtab(pool.back().get());
+    }
+
+    char* str = pool.back().get() + pool_used;
+    memcpy(str, entry.symbol.data(), entry.symbol.length());
+    str[entry.symbol.length()] = '\0';
+    Insert(entry.offset, entry.type, entry.size, pool_strtab, pool_used);
+    pool_used += length;
+}
+
+void SymbolTable::Adopt(std::unique_ptr<MemoryMap>& map, const Record* recs, uint64_t count,
+                        const char* strtab, uint64_t m) {
+    clear();
+    uint16_t index = AddStrtab(strtab);
+    records.assign(recs, recs + count);
+    for (auto& record : records)
+        record.strtab = index;
+    Hold(map);
+
+    mask = m;
+    BuildMaxEnds();
+}
+
+void SymbolTable::Build(uint64_t m) {
+    mask = m;
+    dirty = false;
+
+    std::stable_sort(records.begin(), records.end(),
+            [&](const Record& a, const Record& b) {
+                uint64_t aoff = a.offset & mask;
+                uint64_t boff = b.offset & mask;
+                if (aoff != boff)
+                    return aoff < boff;
+                if (a.offset != b.offset)
+                    return a.offset < b.offset;
+                if (a.size != b.size)
+                    return a.size < b.size;
+                return a.type < b.type;
+            });
+    // same as unordered_set, keep the first (offset, type, size)
+    records.erase(std::unique(records.begin(), records.end(),
+            [](const Record& a, const Record& b) {
+                return a.offset == b.offset && a.type == b.type && a.size == b.size;
+            }), records.end());
+    records.shrink_to_fit();
+
+    BuildMaxEnds();
+
+    // name index is built on the first Find, most tables only see pcs.
+    names.clear();
+    names_once.reset(new std::once_flag);
+}
+
+void SymbolTable::BuildMaxEnds() {
+    max_ends.resize(records.size());
+    uint64_t max_end = 0;
+    for (int i = 0; i < records.size(); ++i) {
+        uint64_t end = (records[i].offset & mask) + records[i].size;
+        if (end > max_end) max_end = end;
+        max_ends[i] = max_end;
+    }
+}
+
+void SymbolTable::BuildNames() {
+    uint64_t capacity = 1;
+    while (capacity < records.size() * 2) capacity <<= 1;
+    names.assign(capacity, 0);
+
+    std::hash<std::string_view> hasher;
+    uint64_t hmask = capacity - 1;
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        std::string_view name(Name(records[i]));
+        if (!name.length())
+            continue;
+
+        uint64_t slot = hasher(name) & hmask;
+        for (; names[slot]; slot = (slot + 1) & hmask) {
+            if (name == Name(records[names[slot] - 1]))
+                break;
+        }
+        // keep the first by sort order
+        if (!names[slot]) names[slot] = i + 1;
+    }
+}
+
+void SymbolTable::clear() {
+    records.clear();
+    max_ends.clear();
+    names.clear();
+    names_once.reset(new std::once_flag);
+    strtabs.clear();
+    maps.clear();
+    pool.clear();
+    pool_strtab = 0;
+    pool_used = 0;
+    pool_size = 0;
+    dirty = false;
+}
+
+SymbolEntry SymbolTable::Find(const char* symbol) {
+    if (dirty) Build(mask);
+    if (records.empty())
+        return SymbolEntry::Invalid();
+    std::call_once(*names_once, [this]() { BuildNames(); });
+
+    std::string_view name(symbol);
+    uint64_t hmask = names.size() - 1;
+    uint64_t slot = std::hash<std::string_view>()(name) & hmask;
+    for (; names[slot]; slot = (slot + 1) & hmask) {
+        const Record& record = records[names[slot] - 1];
+        if (name == Name(record))
+            return MakeEntry(record);
+    }
+    return SymbolEntry::Invalid();
+}
+
+SymbolEntry SymbolTable::FindRegion(uint64_t offset) {
+    if (dirty) Build(mask);
+
+    const auto& it = std::upper_bound(records.begin(), records.end(), offset,
+            [&](uint64_t value, const Record& record) {
+                return value < (record.offset & mask);
+            });
+
+    int index = (it - records.begin()) - 1;
+    for (; index >= 0 && max_ends[index] > offset; --index) {
+        const Record& record = records[index];
+        if (offset < (record.offset & mask) + record.size)
+            return MakeEntry(record);
+    }
+    return SymbolEntry::Invalid();
+}
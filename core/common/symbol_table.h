@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_COMMON_SYMBOL_TABLE_H_
+#define CORE_COMMON_SYMBOL_TABLE_H_
+
+#include "common/syment.h"
+#include "base/memory_map.h"
+#include <stdint.h>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+ * Immutable symbol index of one ELF image.
+ *
+ *   Insert() ... Insert()  ->  Build(mask)  ->  FindRegion()/Find()
+ *
+ * entries are sorted by (offset & mask), max_ends[i] keeps the largest
+ * end of entries[0..i] so nested or overlapped symbols are still found
+ * by walking back from the upper bound only while a region can cover pc.
+ *
+ * A record is (offset, size, type, strtab, name), names stay in the
+ * string tables of the mapped ELF files the table holds, or in a small
+ * pool for names copied out of core memory. SymbolEntry is only made
+ * when a record is returned, its symbol views the table's memory.
+ *
+ * After Build() or Adopt() lookups may run from many threads, the name
+ * index is then built once under names_once. Insert() and clear() need
+ * the table to themselves.
+ */
+class SymbolTable {
+public:
+    static constexpr uint64_t kPoolChunkSize = 256 * 1024;
+
+    SymbolTable() : mask(-1), dirty(false), names_once(new std::once_flag),
+                    pool_strtab(0), pool_used(0), pool_size(0) {}
+
+    struct Record {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t name;    // offset in strtabs[strtab]
+        uint16_t strtab;
+        uint8_t type;
+    };
+
+    class const_iterator {
+    public:
+        const_iterator(const SymbolTable* t, std::vector<Record>::const_iterator i) : table(t), it(i) {}
+        SymbolEntry operator*() const { return table->MakeEntry(*it); }
+        const_iterator& operator++() { ++it; return *this; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+    private:
+        const SymbolTable* table;
+        std::vector<Record>::const_iterator it;
+    };
+
+    // names stay in base, keep its memory alive with Hold().
+    uint16_t AddStrtab(const char* base);
+    void Hold(std::unique_ptr<MemoryMap>& map) { maps.push_back(std::move(map)); }
+    void Insert(uint64_t offset, uint64_t type, uint64_t size, uint16_t strtab, uint32_t name) {
+        records.push_back({offset, size, name, strtab, static_cast<uint8_t>(type)});
+        dirty = true;
+    }
+    // copies the name, for symbols read from core memory.
+    void Insert(const SymbolEntry& entry);
+    // records already sorted by Build(m), names are offsets into strtab.
+    void Adopt(std::unique_ptr<MemoryMap>& map, const Record* recs, uint64_t count,
+               const char* strtab, uint64_t m);
+    inline const std::vector<Record>& GetRecords() const { return records; }
+    inline const char* Name(const Record& record) const {
+        return strtabs[record.strtab] + record.name;
+    }
+    void Build(uint64_t m);
+    void clear();
+    inline size_t size() const { return records.size(); }
+    inline bool empty() const { return records.empty(); }
+    inline const_iterator begin() const { return const_iterator(this, records.begin()); }
+    inline const_iterator end() const { return const_iterator(this, records.end()); }
+
+    // Invalid() if not found.
+    SymbolEntry Find(const char* symbol);
+    SymbolEntry FindRegion(uint64_t offset);
+private:
+    inline SymbolEntry MakeEntry(const Record& record) const {
+        return SymbolEntry(record.offset, record.type, record.size, Name(record));
+    }
+    void BuildMaxEnds();
+    void BuildNames();
+
+    uint64_t mask;
+    bool dirty;
+    std::vector<Record> records;
+    std::vector<uint64_t> max_ends;
+    // open addressing, record index + 1, 0 is empty.
+    std::vector<uint32_t> names;
+    std::unique_ptr<std::once_flag> names_once;
+    std::vector<const char*> strtabs;
+    std::vector<std::unique_ptr<MemoryMap>> maps;
+    std::vector<std::unique_ptr<char[]>> pool;
+    uint16_t pool_strtab;
+    uint64_t pool_used;
+    uint64_t pool_size;
+};
+
+#endif // CORE_COMMON_SYMBOL_TABLE_H_
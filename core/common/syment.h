@@ -19,7 +19,7 @@
 
 #include <stdint.h>
 #include <sys/types.h>
-#include <string>
+#include <string_view>
 #include <functional>
 
 class SymbolEntry {
@@ -34,7 +34,12 @@ public:
     uint64_t offset;
     uint64_t type;
     uint64_t size;
-    std::string symbol;
+    /*
+     * points into the owning SymbolTable, NUL terminated. Only valid until
+     * the table is cleared or read again (ReadSymbols, ReadDynsyms, sysroot
+     * changes), copy it to keep the name longer.
+     */
+    std::string_view symbol;
 
     bool operator==(const SymbolEntry& entry) const {
         return offset == entry.offset
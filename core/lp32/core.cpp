@@ -287,7 +287,7 @@ bool lp32::Core::loader_dlopen32(CoreApi* api, MemoryMap* map, ::LinkMap* handle
 }
 
 static void ReadSymbolEntry32(std::unique_ptr<MemoryMap>& map, int symndx, int strndx,
-                            std::unordered_set<SymbolEntry, SymbolEntry::Hash>& symbols) {
+                            SymbolTable& symbols) {
     if (!symndx || !strndx)
         return;
 
@@ -297,20 +297,21 @@ static void ReadSymbolEntry32(std::unique_ptr<MemoryMap>& map, int symndx, int s
     int count = shdr[symndx].sh_size / shdr[symndx].sh_entsize;
     Elf32_Sym* symtab = reinterpret_cast<Elf32_Sym*>(map->data() + shdr[symndx].sh_offset);
     const char* strtab = reinterpret_cast<const char*>(map->data() + shdr[strndx].sh_offset);
+    uint16_t strtabndx = symbols.AddStrtab(strtab);
     for (int i = 0; i < count; ++i) {
         if (symtab[i].st_value && symtab[i].st_size) {
-            SymbolEntry entry = SymbolEntry(symtab[i].st_value, symtab[i].st_info, symtab[i].st_size,
-                    const_cast<const char*>(strtab + symtab[i].st_name));
             // skip mapping symbols and internal labels
-            if (entry.symbol.size() > 0 && (entry.symbol[0] == '$' || entry.symbol[0] == '.'))
+            const char* name = strtab + symtab[i].st_name;
+            if (name[0] == '$' || name[0] == '.')
                 continue;
-            symbols.insert(entry);
+            symbols.Insert(symtab[i].st_value, symtab[i].st_info, symtab[i].st_size,
+                           strtabndx, symtab[i].st_name);
         }
     }
 }
 
 static void ReadSymbol32(std::unique_ptr<MemoryMap>& map,
-                         std::unordered_set<SymbolEntry, SymbolEntry::Hash>& symbols) {
+                         SymbolTable& symbols) {
     if (!map) return;
 
     int dynsymndx = 0;
@@ -353,16 +354,16 @@ static void ReadSymbol32(std::unique_ptr<MemoryMap>& map,
         }
     }
 
+    uint64_t count = symbols.size();
     ReadSymbolEntry32(map, dynsymndx, dynstrndx, symbols);
     ReadSymbolEntry32(map, symtabndx, strtabndx, symbols);
+    // names are not copied, the table keeps the file mapped.
+    if (symbols.size() > count)
+        symbols.Hold(map);
 }
 
-void lp32::Core::readsym32(::LinkMap* handle) {
-    if (!handle->block())
-        return;
-
+static void ReadSymbolTable32(::LinkMap* handle, SymbolTable& symbols) {
     std::unique_ptr<MemoryMap> map(MemoryMap::MmapFile(handle->block()->name().c_str(), handle->block()->GetMmapOffset()));
-    std::unordered_set<SymbolEntry, SymbolEntry::Hash>& symbols = handle->block()->GetSymbols();
     if (map) {
         // already check valid on dlopen
         int gnu_debugdatandx = 0;
@@ -396,6 +397,7 @@ void lp32::Core::readsym32(::LinkMap* handle) {
             }
         }
 
+        MemoryMap* file = map.get();
         ReadSymbol32(map, symbols);
 
         // scan gnu_debugdata
@@ -404,7 +406,7 @@ void lp32::Core::readsym32(::LinkMap* handle) {
                 return;
 
             std::unique_ptr<xz::Codec> codec = xz::Codec::Create(
-                    reinterpret_cast<uint8_t *>(map->data() + shdr[gnu_debugdatandx].sh_offset),
+                    reinterpret_cast<uint8_t *>(file->data() + shdr[gnu_debugdatandx].sh_offset),
                     shdr[gnu_debugdatandx].sh_size);
 
             if (!codec)
@@ -414,7 +416,7 @@ void lp32::Core::readsym32(::LinkMap* handle) {
             if (debug_map) {
                 ElfHeader* header = reinterpret_cast<ElfHeader*>(debug_map->data());
                 std::string anon_name = "anon:gnu_debugdata_";
-                anon_name.append(map->getName());
+                anon_name.append(file->getName());
                 if (!header->CheckLibrary(anon_name.c_str()))
                     return;
                 ReadSymbol32(debug_map, symbols);
@@ -422,3 +424,12 @@ void lp32::Core::readsym32(::LinkMap* handle) {
         }
     }
 }
+
+void lp32::Core::readsym32(::LinkMap* handle) {
+    if (!handle->block())
+        return;
+
+    SymbolTable& symbols = handle->block()->GetSymbols();
+    ReadSymbolTable32(handle, symbols);
+    symbols.Build(::LinkMap::SymbolMask());
+}
@@ -30,8 +30,23 @@ uint64_t UnwindStack::GetUContext() {
 void UnwindStack::WalkStack() {
     ThreadInfo* thread = reinterpret_cast<ThreadInfo*>(GetThread());
     Register& regs = thread->GetRegs();
-    cur_frame_pc_ = regs.pc;
-    VisitFrame();
+
+    // ra, sp, ... t6 follow pc as dwarf registers 1 ... 31, x0 is zero.
+    EhFrame::Regs cfi;
+    uint64_t* x = &regs.pc;
+    cfi.set(0, 0x0);
+    for (int i = 1; i < 32; ++i)
+        cfi.set(i, x[i]);
+    cfi.pc = regs.pc;
+    if (CfiBacktrace(cfi, 2, 8, 0x2))
+        return;
+
+    try {
+        cur_frame_pc_ = regs.pc;
+        VisitFrame();
+    } catch(InvalidAddressException& e) {
+        // do nothing
+    }
 }
 
 void UnwindStack::DumpContextRegister(const char* prefix) {
@@ -106,6 +106,18 @@ void UnwindStack::WalkStack() {
 }
 
 void UnwindStack::Backtrace(Register& regs) {
+    // rax, rdx, rcx, rbx, rsi, rdi, rbp, rsp, r8 ... r15 are dwarf registers 0 ... 15
+    EhFrame::Regs cfi;
+    uint64_t values[] = { regs.rax, regs.rdx, regs.rcx, regs.rbx,
+                          regs.rsi, regs.rdi, regs.rbp, regs.rsp,
+                          regs.r8, regs.r9, regs.r10, regs.r11,
+                          regs.r12, regs.r13, regs.r14, regs.r15 };
+    for (int i = 0; i < 16; ++i)
+        cfi.set(i, values[i]);
+    cfi.pc = regs.rip;
+    if (CfiBacktrace(cfi, 7, 6, 0x1))
+        return;
+
     try {
         cur_frame_pc_ = regs.rip;
         VisitFrame();
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "android.h"
+#include "command/android/cmd_gcroot.h"
+#include "common/exception.h"
+#include "java/lang/Object.h"
+#include "runtime/mirror/class.h"
+#include "runtime/mirror/array.h"
+#include "runtime/art_field.h"
+#include "base/utils.h"
+#include "api/core.h"
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <vector>
+
+int GcRootCommand::prepare(int argc, char* const argv[]) {
+    if (!CoreApi::IsReady()
+            || !Android::IsSdkReady()
+            || !(argc > 1))
+        return Command::FINISH;
+
+    options.weak = false;
+
+    int opt;
+    int option_index = 0;
+    optind = 0; // reset
+    static struct option long_options[] = {
+        {"weak",    no_argument,       0,  'w'},
+        {0,         0,                 0,   0 },
+    };
+
+    while ((opt = getopt_long(argc, argv, "w",
+                long_options, &option_index)) != -1) {
+        switch (opt) {
+            case 'w':
+                options.weak = true;
+                break;
+        }
+    }
+    options.optind = optind;
+
+    if (options.optind >= argc) {
+        usage();
+        return Command::FINISH;
+    }
+
+    Android::Prepare();
+    // build in parent, later commands reuse it.
+    android::HeapGraph::Get();
+    references.clear();
+    return Command::ONCHLD;
+}
+
+static std::string PrettyObjectDescriptor(art::mirror::Object& object) {
+    art::mirror::Class thiz = 0x0;
+    if (object.IsClass()) {
+        thiz = object;
+    } else {
+        thiz = object.GetClass();
+    }
+    return thiz.PrettyDescriptor();
+}
+
+int GcRootCommand::main(int argc, char* const argv[]) {
+    android::HeapGraph* graph = android::HeapGraph::Get();
+    uint64_t addr = Utils::atol(argv[options.optind]);
+    // heap references are 32-bit, don't let a truncated address match.
+    if (addr > UINT32_MAX) {
+        LOGE("0x%" PRIx64 " is not a heap object.\n", addr);
+        return 0;
+    }
+    uint32_t target = graph->Find(addr);
+    if (target == android::HeapGraph::kInvalid) {
+        LOGE("0x%" PRIx64 " is not a heap object.\n", addr);
+        return 0;
+    }
+
+    int mask = options.weak ? ~0 : android::HeapGraph::ROOT_STRONG;
+    std::vector<uint8_t> kinds(graph->size(), 0);
+    for (const auto& root : graph->GetRoots()) {
+        if (root.kind & mask)
+            kinds[root.node] |= root.kind;
+    }
+
+    /*
+     * breadth first back from the target over inbound edges, the first
+     * root met ends the same shortest chain a walk from all roots finds,
+     * next[] points one hop closer to the target.
+     */
+    std::vector<uint32_t> next(graph->size(), android::HeapGraph::kInvalid);
+    std::vector<uint32_t> queue;
+    uint32_t found = android::HeapGraph::kInvalid;
+    try {
+        next[target] = target;
+        queue.push_back(target);
+        for (uint64_t i = 0; i < queue.size(); ++i) {
+            uint32_t node = queue[i];
+            if (kinds[node]) {
+                found = node;
+                break;
+            }
+            for (uint32_t source : graph->Inbound(node)) {
+                if (next[source] != android::HeapGraph::kInvalid)
+                    continue;
+                if (!options.weak && IsWeakEdge(graph, source, node))
+                    continue;
+                next[source] = node;
+                queue.push_back(source);
+            }
+        }
+
+        if (found == android::HeapGraph::kInvalid) {
+            LOGI("No path to gc roots.\n");
+            return 0;
+        }
+
+        std::string root_desc;
+        for (int kind = 1; kind <= android::HeapGraph::ROOT_STICKY_CLASS; kind <<= 1) {
+            if (!(kinds[found] & kind))
+                continue;
+            if (root_desc.length()) root_desc.append("|");
+            root_desc.append(android::HeapGraph::GetRootName(kind));
+        }
+
+        art::mirror::Object root = graph->GetAddress(found);
+        LOGI("[%s] " ANSI_COLOR_LIGHTYELLOW "0x%" PRIx64 " " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
+                root_desc.c_str(), root.Ptr(), PrettyObjectDescriptor(root).c_str());
+        for (uint32_t node = found; node != target; node = next[node]) {
+            art::mirror::Object source = graph->GetAddress(node);
+            art::mirror::Object object = graph->GetAddress(next[node]);
+            std::string slot = DescribeSlot(source, object.Ptr(), !options.weak);
+            LOGI("  " ANSI_COLOR_LIGHTGREEN "%s" ANSI_COLOR_RESET " --> " ANSI_COLOR_LIGHTYELLOW "0x%" PRIx64 " " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
+                    slot.c_str(), object.Ptr(), PrettyObjectDescriptor(object).c_str());
+        }
+    } catch(InvalidAddressException& e) {
+        LOGE("%s\n", e.what());
+    }
+    return 0;
+}
+
+bool GcRootCommand::IsWeakEdge(android::HeapGraph* graph, uint32_t source, uint32_t target) {
+    uint32_t klass = graph->GetClass(source);
+    auto it = references.find(klass);
+    art::mirror::Object object = graph->GetAddress(source);
+    if (it == references.end()) {
+        java::lang::Object java = object;
+        bool is_reference = !object.IsClass() && java.instanceof("java.lang.ref.Reference");
+        it = references.emplace(klass, is_reference).first;
+    }
+    if (!it->second)
+        return false;
+    return !DescribeSlot(object, graph->GetAddress(target), true).length();
+}
+
+std::string GcRootCommand::DescribeSlot(art::mirror::Object& source, uint32_t target, bool strong_only) {
+    std::string desc;
+    auto field_fn = [&](art::ArtField& field) -> bool {
+        if (Android::SignatureToBasicTypeAndSize(field.GetTypeDescriptor(), nullptr, "B") != Android::basic_object
+                || field.Get32(source) != target)
+            return false;
+        const char* name = field.GetName();
+        if (strong_only && !strcmp(name, "referent")
+                && field.GetDeclaringClass().PrettyDescriptor() == "java.lang.ref.Reference")
+            return false;
+        desc.append(field.IsStatic() ? "static ." : ".").append(name);
+        return true;
+    };
+
+    if (source.IsClass()) {
+        art::mirror::Class clazz = source;
+        Android::ForeachStaticField(clazz, field_fn);
+    }
+
+    art::mirror::Class current = source.GetClass();
+    while (!desc.length() && current.Ptr()) {
+        Android::ForeachInstanceField(current, field_fn);
+        current = current.GetSuperClass();
+    }
+
+    if (!desc.length() && source.IsObjectArray()) {
+        art::mirror::Array array = source;
+        int32_t length = array.GetLength();
+        for (int32_t i = 0; i < length; ++i) {
+            api::MemoryRef ref(array.GetRawData(sizeof(uint32_t), i), array);
+            if (*reinterpret_cast<uint32_t *>(ref.Real()) == target) {
+                desc.append("[").append(std::to_string(i)).append("]");
+                break;
+            }
+        }
+    }
+    return desc;
+}
+
+void GcRootCommand::usage() {
+    LOGI("Usage: gcroot <OBJECT> [OPTION]\n");
+    LOGI("Option:\n");
+    LOGI("    -w, --weak      also follow weak references and weak globals\n");
+    ENTER();
+    LOGI("core-parser> gcroot 0x12c4b2a0\n");
+    LOGI("[Sticky Class] 0x70ab1230 com.example.App\n");
+    LOGI("  static .sActivities --> 0x12c0ab10 java.util.ArrayList\n");
+    LOGI("  .elementData --> 0x12c0ab28 java.lang.Object[]\n");
+    LOGI("  [3] --> 0x12c4b2a0 com.example.MainActivity\n");
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PARSER_COMMAND_ANDROID_CMD_GCROOT_H_
+#define PARSER_COMMAND_ANDROID_CMD_GCROOT_H_
+
+#include "command/command.h"
+#include "runtime/mirror/object.h"
+#include "heap/heap_graph.h"
+#include <string>
+#include <unordered_map>
+
+class GcRootCommand : public Command {
+public:
+    GcRootCommand() : Command("gcroot") {}
+    ~GcRootCommand() {}
+
+    struct Options : Command::Options {
+        bool weak;
+    };
+
+    int main(int argc, char* const argv[]);
+    int prepare(int argc, char* const argv[]);
+    void usage();
+    bool IsWeakEdge(android::HeapGraph* graph, uint32_t source, uint32_t target);
+    static std::string DescribeSlot(art::mirror::Object& source, uint32_t target, bool strong_only);
+private:
+    Options options;
+    // class -> extends java.lang.ref.Reference
+    std::unordered_map<uint32_t, bool> references;
+};
+
+#endif // PARSER_COMMAND_ANDROID_CMD_GCROOT_H_
@@ -0,0 +1,385 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "command/android/cmd_histogram.h"
+#include "runtime/mirror/class.h"
+#include "api/core.h"
+#include "android.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+typedef int (*HistogramCall)(int argc, char* const argv[]);
+struct HistogramOption {
+    const char* cmd;
+    HistogramCall call;
+    bool onbg;
+};
+
+static HistogramOption histogram_option[] = {
+    { "dump", HistogramCommand::Dump, true },
+    { "diff", HistogramCommand::Diff, false },
+};
+
+int HistogramCommand::prepare(int argc, char* const argv[]) {
+    if (!(argc > 1)) {
+        usage();
+        return Command::FINISH;
+    }
+
+    int count = sizeof(histogram_option)/sizeof(histogram_option[0]);
+    for (int index = 0; index < count; ++index) {
+        if (strcmp(argv[1], histogram_option[index].cmd))
+            continue;
+        if (!histogram_option[index].onbg)
+            return Command::CONTINUE;
+        if (!CoreApi::IsReady() || !Android::IsSdkReady())
+            return Command::FINISH;
+        Android::Prepare();
+        return Command::ONCHLD;
+    }
+    usage();
+    return Command::FINISH;
+}
+
+int HistogramCommand::main(int argc, char* const argv[]) {
+    int count = sizeof(histogram_option)/sizeof(histogram_option[0]);
+    for (int index = 0; index < count; ++index) {
+        if (!strcmp(argv[1], histogram_option[index].cmd)) {
+            return histogram_option[index].call(argc - 1, &argv[1]);
+        }
+    }
+    return 0;
+}
+
+int HistogramCommand::Dump(int argc, char* const argv[]) {
+    bool csv = false;
+    int obj_each_flags = 0;
+
+    int opt;
+    int option_index = 0;
+    optind = 0; // reset
+    static struct option long_options[] = {
+        {"csv",        no_argument,       0,  'c'},
+        {"app",        no_argument,       0,   1 },
+        {"zygote",     no_argument,       0,   2 },
+        {"image",      no_argument,       0,   3 },
+        {"fake",       no_argument,       0,   4 },
+        {0,            0,                 0,   0 },
+    };
+
+    while ((opt = getopt_long(argc, argv, "c",
+                long_options, &option_index)) != -1) {
+        switch (opt) {
+            case 'c':
+                csv = true;
+                break;
+            case 1:
+                obj_each_flags |= Android::EACH_APP_OBJECTS;
+                break;
+            case 2:
+                obj_each_flags |= Android::EACH_ZYGOTE_OBJECTS;
+                break;
+            case 3:
+                obj_each_flags |= Android::EACH_IMAGE_OBJECTS;
+                break;
+            case 4:
+                obj_each_flags |= Android::EACH_FAKE_OBJECTS;
+                break;
+        }
+    }
+
+    if (optind >= argc) {
+        LOGE("missing snapshot file.\n");
+        return 0;
+    }
+    const char* path = argv[optind];
+
+    if (!obj_each_flags) {
+        obj_each_flags |= Android::EACH_APP_OBJECTS;
+        obj_each_flags |= Android::EACH_ZYGOTE_OBJECTS;
+        obj_each_flags |= Android::EACH_IMAGE_OBJECTS;
+        obj_each_flags |= Android::EACH_FAKE_OBJECTS;
+    }
+
+    TopCommand::ClassTable table;
+    TopCommand::Collect(table, obj_each_flags, 0);
+
+    // same descriptor from different class loaders folds into one row.
+    Snapshot snapshot;
+    for (const auto& entry : table.GetSlots()) {
+        if (!entry.klass || !entry.pair.alloc_count)
+            continue;
+        art::mirror::Class thiz = entry.klass;
+        TopCommand::Pair& pair = snapshot[thiz.PrettyDescriptor()];
+        pair.alloc_count += entry.pair.alloc_count;
+        pair.shallow_size += entry.pair.shallow_size;
+        pair.native_size += entry.pair.native_size;
+    }
+
+    if (Save(snapshot, path, csv))
+        LOGI("Saved %" PRIu64 " classes to %s\n", static_cast<uint64_t>(snapshot.size()), path);
+    return 0;
+}
+
+int HistogramCommand::Diff(int argc, char* const argv[]) {
+    int order = ORDERBY_SHALLOW;
+
+    int opt;
+    int option_index = 0;
+    optind = 0; // reset
+    static struct option long_options[] = {
+        {"alloc",      no_argument,       0,  'a'},
+        {"shallow",    no_argument,       0,  's'},
+        {"native",     no_argument,       0,  'n'},
+        {0,            0,                 0,   0 },
+    };
+
+    while ((opt = getopt_long(argc, argv, "asn",
+                long_options, &option_index)) != -1) {
+        switch (opt) {
+            case 'a':
+                order = ORDERBY_ALLOC;
+                break;
+            case 's':
+                order = ORDERBY_SHALLOW;
+                break;
+            case 'n':
+                order = ORDERBY_NATIVE;
+                break;
+        }
+    }
+
+    if (optind + 2 > argc) {
+        LOGE("missing snapshot file.\n");
+        return 0;
+    }
+    int num = optind + 2 < argc ? std::atoi(argv[optind + 2]) : 0;
+
+    Snapshot before;
+    Snapshot after;
+    if (!Load(before, argv[optind]) || !Load(after, argv[optind + 1]))
+        return 0;
+
+    struct Delta {
+        const std::string* name;
+        int64_t alloc_count;
+        int64_t shallow_size;
+        int64_t native_size;
+    };
+
+    // both maps are sorted by name, merge them in one pass.
+    std::vector<Delta> deltas;
+    Delta total = {nullptr, 0, 0, 0};
+    auto add = [&](const std::string& name, const TopCommand::Pair& pair, int sign) {
+        if (!deltas.size() || *deltas.back().name != name)
+            deltas.push_back({&name, 0, 0, 0});
+        Delta& delta = deltas.back();
+        delta.alloc_count += sign * static_cast<int64_t>(pair.alloc_count);
+        delta.shallow_size += sign * static_cast<int64_t>(pair.shallow_size);
+        delta.native_size += sign * static_cast<int64_t>(pair.native_size);
+        total.alloc_count += sign * static_cast<int64_t>(pair.alloc_count);
+        total.shallow_size += sign * static_cast<int64_t>(pair.shallow_size);
+        total.native_size += sign * static_cast<int64_t>(pair.native_size);
+    };
+    auto bit = before.begin();
+    auto ait = after.begin();
+    while (bit != before.end() || ait != after.end()) {
+        if (ait == after.end() || (bit != before.end() && bit->first < ait->first)) {
+            add(bit->first, bit->second, -1);
+            ++bit;
+        } else if (bit == before.end() || ait->first < bit->first) {
+            add(ait->first, ait->second, 1);
+            ++ait;
+        } else {
+            add(bit->first, bit->second, -1);
+            add(ait->first, ait->second, 1);
+            ++bit;
+            ++ait;
+        }
+    }
+
+    auto key = [&](const Delta& delta) -> int64_t {
+        switch (order) {
+            case ORDERBY_ALLOC: return delta.alloc_count;
+            case ORDERBY_NATIVE: return delta.native_size;
+            default: return delta.shallow_size;
+        }
+    };
+    deltas.erase(std::remove_if(deltas.begin(), deltas.end(), [](const Delta& delta) {
+        return !delta.alloc_count && !delta.shallow_size && !delta.native_size;
+    }), deltas.end());
+    // stable keeps equal growth in name order.
+    std::stable_sort(deltas.begin(), deltas.end(), [&](const Delta& a, const Delta& b) {
+        return key(a) > key(b);
+    });
+    if (num > 0 && static_cast<uint64_t>(num) < deltas.size())
+        deltas.resize(num);
+
+    LOGI(ANSI_COLOR_LIGHTRED "Allocations      ShallowSize        NativeSize     ClassName\n" ANSI_COLOR_RESET);
+    LOGI(ANSI_COLOR_LIGHTMAGENTA "%+11" PRId64 "      " ANSI_COLOR_LIGHTBLUE "%+11" PRId64 "       " ANSI_COLOR_LIGHTGREEN "%+11" PRId64 "     " ANSI_COLOR_RESET "TOTAL\n",
+         total.alloc_count, total.shallow_size, total.native_size);
+    LOGI("------------------------------------------------------------\n");
+    for (const auto& delta : deltas) {
+        LOGI("%+11" PRId64 "      " "%+11" PRId64 "       " "%+11" PRId64 "     " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
+             delta.alloc_count, delta.shallow_size, delta.native_size, delta.name->c_str());
+    }
+    return 0;
+}
+
+bool HistogramCommand::Save(Snapshot& snapshot, const char* path, bool csv) {
+    std::string buffer;
+    if (csv) {
+        buffer.append("count,shallow,native,name\n");
+        char line[96];
+        for (const auto& value : snapshot) {
+            snprintf(line, sizeof(line), "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",",
+                     value.second.alloc_count, value.second.shallow_size, value.second.native_size);
+            buffer.append(line).append(value.first).append("\n");
+        }
+    } else {
+        auto put = [&](const void* data, uint64_t size) {
+            buffer.append(reinterpret_cast<const char*>(data), size);
+        };
+        uint64_t count = snapshot.size();
+        put(&kMagic, sizeof(kMagic));
+        put(&count, sizeof(count));
+        for (const auto& value : snapshot) {
+            uint32_t length = value.first.length();
+            put(&value.second.alloc_count, sizeof(uint64_t));
+            put(&value.second.shallow_size, sizeof(uint64_t));
+            put(&value.second.native_size, sizeof(uint64_t));
+            put(&length, sizeof(length));
+            put(value.first.data(), length);
+        }
+    }
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        LOGE("Can not create %s\n", path);
+        return false;
+    }
+    bool errors = buffer.size() && !fwrite(buffer.data(), buffer.size(), 1, fp);
+    errors |= fclose(fp) != 0;
+    if (errors) {
+        LOGE("Write %s fail!\n", path);
+        remove(path);
+        return false;
+    }
+    return true;
+}
+
+bool HistogramCommand::Load(Snapshot& snapshot, const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOGE("Can not open %s\n", path);
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint64_t magic = 0;
+    if (data.size() >= sizeof(magic))
+        memcpy(&magic, data.data(), sizeof(magic));
+
+    if (magic == kMagic) {
+        uint64_t pos = sizeof(magic);
+        auto get = [&](void* out, uint64_t size) -> bool {
+            if (pos + size > data.size())
+                return false;
+            memcpy(out, data.data() + pos, size);
+            pos += size;
+            return true;
+        };
+        uint64_t count = 0;
+        bool valid = get(&count, sizeof(count));
+        for (uint64_t i = 0; valid && i < count; ++i) {
+            TopCommand::Pair pair = {0, 0, 0, 0};
+            uint32_t length = 0;
+            valid = get(&pair.alloc_count, sizeof(uint64_t))
+                    && get(&pair.shallow_size, sizeof(uint64_t))
+                    && get(&pair.native_size, sizeof(uint64_t))
+                    && get(&length, sizeof(length))
+                    && pos + length <= data.size();
+            if (valid) {
+                // sum duplicates the same way the csv path does.
+                TopCommand::Pair& value = snapshot[data.substr(pos, length)];
+                value.alloc_count += pair.alloc_count;
+                value.shallow_size += pair.shallow_size;
+                value.native_size += pair.native_size;
+                pos += length;
+            }
+        }
+        if (!valid) {
+            LOGE("%s is truncated.\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t pos = data.find('\n');
+    if (pos == std::string::npos || data.compare(0, pos, "count,shallow,native,name")) {
+        LOGE("%s is not a histogram snapshot.\n", path);
+        return false;
+    }
+    while (++pos < data.size()) {
+        uint64_t end = data.find('\n', pos);
+        if (end == std::string::npos)
+            end = data.size();
+        TopCommand::Pair pair = {0, 0, 0, 0};
+        int offset = 0;
+        std::string line = data.substr(pos, end - pos);
+        if (sscanf(line.c_str(), "%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%n",
+                   &pair.alloc_count, &pair.shallow_size, &pair.native_size, &offset) != 3 || !offset) {
+            LOGE("%s bad line: %s\n", path, line.c_str());
+            return false;
+        }
+        TopCommand::Pair& value = snapshot[line.substr(offset)];
+        value.alloc_count += pair.alloc_count;
+        value.shallow_size += pair.shallow_size;
+        value.native_size += pair.native_size;
+        pos = end;
+    }
+    return true;
+}
+
+void HistogramCommand::usage() {
+    LOGI("Usage: histogram <COMMAND> [OPTION...]\n");
+    LOGI("Command:\n");
+    LOGI("    dump <FILE> [-c|--csv] [TYPE]\n");
+    LOGI("    diff <OLD> <NEW> [NUM] [-a|-s|-n]\n");
+    LOGI("Option:\n");
+    LOGI("    -c, --csv       write csv instead of the binary snapshot\n");
+    LOGI("    -a, --alloc     order by allocation growth\n");
+    LOGI("    -s, --shallow   order by shallow growth (default)\n");
+    LOGI("    -n, --native    order by native growth\n");
+    LOGI("Type: {--app, --zygote, --image, --fake}\n");
+    ENTER();
+    LOGI("core-parser> histogram dump before.histo\n");
+    LOGI("Saved 5123 classes to before.histo\n");
+    ENTER();
+    LOGI("core-parser> histogram diff before.histo after.histo 3\n");
+    LOGI("Allocations      ShallowSize        NativeSize     ClassName\n");
+    LOGI("      +4862         +1193440            +81920     TOTAL\n");
+    LOGI("------------------------------------------------------------\n");
+    LOGI("       +512          +524800                +0     byte[]\n");
+    LOGI("      +2301          +156468                +0     java.lang.String\n");
+    LOGI("        +40           +12800            +81920     android.graphics.Bitmap\n");
+}
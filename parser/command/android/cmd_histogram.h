@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PARSER_COMMAND_ANDROID_CMD_HISTOGRAM_H_
+#define PARSER_COMMAND_ANDROID_CMD_HISTOGRAM_H_
+
+#include "command/command.h"
+#include "command/android/cmd_top.h"
+#include <stdint.h>
+#include <string>
+#include <map>
+
+/*
+ * top style class histogram keyed by descriptor, so two cores of the same
+ * app line up even though class addresses move.
+ *
+ * binary snapshot:
+ *  ----------------------------------------------------------------------
+ * | magic | count | (alloc, shallow, native, name_length, name) ... |
+ *  ----------------------------------------------------------------------
+ *
+ * csv snapshot: "count,shallow,native,name" then one class per line,
+ * name last so it never needs quoting.
+ */
+class HistogramCommand : public Command {
+public:
+    static constexpr uint64_t kMagic = 0x3130304f54534948ULL; // "HISTO001"
+    static constexpr int ORDERBY_ALLOC = TopCommand::ORDERBY_ALLOC;
+    static constexpr int ORDERBY_SHALLOW = TopCommand::ORDERBY_SHALLOW;
+    static constexpr int ORDERBY_NATIVE = TopCommand::ORDERBY_NATIVE;
+
+    HistogramCommand() : Command("histogram") {}
+    ~HistogramCommand() {}
+
+    typedef std::map<std::string, TopCommand::Pair> Snapshot;
+
+    int main(int argc, char* const argv[]);
+    int prepare(int argc, char* const argv[]);
+    void usage();
+
+    static int Dump(int argc, char* const argv[]);
+    static int Diff(int argc, char* const argv[]);
+    static bool Save(Snapshot& snapshot, const char* path, bool csv);
+    static bool Load(Snapshot& snapshot, const char* path);
+};
+
+#endif // PARSER_COMMAND_ANDROID_CMD_HISTOGRAM_H_
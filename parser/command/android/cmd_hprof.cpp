@@ -28,6 +28,7 @@ int HprofCommand::prepare(int argc, char* const argv[]) {
 
     options.visible = false;
     options.quick = false;
+    options.stream = false;
 
     int opt;
     int option_index = 0;
@@ -35,10 +36,11 @@ int HprofCommand::prepare(int argc, char* const argv[]) {
     static struct option long_options[] = {
         {"visible",  no_argument,      0, 'v'},
         {"quick",    no_argument,      0, 'q'},
+        {"stream",   no_argument,      0, 's'},
         {0,          0,                0,  0 },
     };
 
-    while ((opt = getopt_long(argc, argv, "vq",
+    while ((opt = getopt_long(argc, argv, "vqs",
                 long_options, &option_index)) != -1) {
         switch (opt) {
             case 'v':
@@ -47,6 +49,9 @@ int HprofCommand::prepare(int argc, char* const argv[]) {
             case 'q':
                 options.quick = true;
                 break;
+            case 's':
+                options.stream = true;
+                break;
         }
     }
     options.optind = optind;
@@ -63,7 +68,7 @@ int HprofCommand::main(int argc, char* const argv[]) {
     } else {
         filename = argv[options.optind];
     }
-    art::hprof::DumpHeap(filename.c_str(), options.visible, options.quick);
+    art::hprof::DumpHeap(filename.c_str(), options.visible, options.quick, options.stream);
     return 0;
 }
 
@@ -72,6 +77,7 @@ void HprofCommand::usage() {
     LOGI("Option:\n");
     LOGI("    -v, --visible     show hprof detail\n");
     LOGI("    -q, --quick       fast dump hprof\n");
+    LOGI("    -s, --stream      single pass dump, string and class table at the end\n");
     ENTER();
     LOGI("core-parser> hprof /tmp/1.hprof\n");
     LOGI("hprof: heap dump /tmp/1.hprof starting...\n");
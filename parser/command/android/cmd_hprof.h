@@ -27,6 +27,7 @@ public:
     struct Options : Command::Options {
         bool visible;
         bool quick;
+        bool stream;
     };
 
     int main(int argc, char* const argv[]);
@@ -85,8 +85,11 @@ int PrintCommand::prepare(int argc, char* const argv[]) {
         return Command::FINISH;
     }
 
-    if (options.reference)
+    if (options.reference) {
         Android::Prepare();
+        // build in parent, later commands reuse it.
+        android::HeapGraph::Get();
+    }
 
     return Command::ONCHLD;
 }
@@ -152,48 +155,43 @@ void PrintCommand::OnlyDumpObject(art::mirror::Object& object, PrintCommand::Opt
     try {
         if (options.reference) {
             LOGI(ANSI_COLOR_LIGHTRED "Reference:\n" ANSI_COLOR_RESET);
-            int cur_deep = 0;
-            auto callback = [&](art::mirror::Object& reference) -> bool {
-                return PrintReference(object, reference, cur_deep, options);
-            };
-            Android::ForeachObjects(callback);
+            android::HeapGraph* graph = android::HeapGraph::Get();
+            uint32_t node = graph->Find(object.Ptr());
+            if (node != android::HeapGraph::kInvalid)
+                PrintReference(graph, node, 0, options);
         }
     } catch(InvalidAddressException& e) {
         // do nothing
     }
 }
 
-bool PrintCommand::PrintReference(art::mirror::Object& object, art::mirror::Object& reference, int cur_deep, PrintCommand::Options& options) {
+void PrintCommand::PrintReference(android::HeapGraph* graph, uint32_t node, int cur_deep, PrintCommand::Options& options) {
     if (cur_deep >= options.deep)
-        return true;
+        return;
 
-    uint64_t real_size = RoundUp(reference.SizeOf(), art::kObjectAlignment);
-    uint64_t count = real_size / sizeof(uint32_t);
     std::string prefix;
     for (int cur = -1; cur < cur_deep; ++cur) {
         prefix.append("  ");
     }
 
-    for (int pos = 0; pos < count; ++pos) {
-        if (object.Ptr() == reference.value32Of(pos * sizeof(uint32_t))) {
-            art::mirror::Class ref_thiz = 0x0;
-            if (reference.IsClass()) {
-                ref_thiz = reference;
-            } else {
-                ref_thiz = reference.GetClass();
-            }
-            LOGI("%s--> " ANSI_COLOR_LIGHTYELLOW "0x%" PRIx64 " " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
-                    prefix.c_str(), reference.Ptr(), ref_thiz.PrettyDescriptor().c_str());
-            if (cur_deep + 1 < options.deep) {
-                auto callback = [&](art::mirror::Object& second) -> bool {
-                    return PrintReference(reference, second, cur_deep + 1, options);
-                };
-                Android::ForeachObjects(callback);
-            }
-            break;
+    uint32_t last = android::HeapGraph::kInvalid;
+    for (uint32_t source : graph->Inbound(node)) {
+        // sources are ascending, one object may hold several slots.
+        if (source == last)
+            continue;
+        last = source;
+
+        art::mirror::Object reference = graph->GetAddress(source);
+        art::mirror::Class ref_thiz = 0x0;
+        if (reference.IsClass()) {
+            ref_thiz = reference;
+        } else {
+            ref_thiz = reference.GetClass();
         }
+        LOGI("%s--> " ANSI_COLOR_LIGHTYELLOW "0x%" PRIx64 " " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
+                prefix.c_str(), reference.Ptr(), ref_thiz.PrettyDescriptor().c_str());
+        PrintReference(graph, source, cur_deep + 1, options);
     }
-    return false;;
 }
 
 void PrintCommand::DumpClass(art::mirror::Class& clazz, PrintCommand::Options& options) {
@@ -23,6 +23,7 @@
 #include "runtime/mirror/array.h"
 #include "runtime/art_field.h"
 #include "android.h"
+#include "heap/heap_graph.h"
 #include <string>
 
 class PrintCommand : public Command {
@@ -46,7 +47,7 @@ public:
     static void DumpClass(art::mirror::Class& clazz, PrintCommand::Options& options);
     static void DumpArray(art::mirror::Array& array, PrintCommand::Options& options);
     static void DumpInstance(art::mirror::Object& object, PrintCommand::Options& options);
-    static bool PrintReference(art::mirror::Object& object, art::mirror::Object& reference, int cur_deep, PrintCommand::Options& options);
+    static void PrintReference(android::HeapGraph* graph, uint32_t node, int cur_deep, PrintCommand::Options& options);
     static void PrintField(const char* format, art::mirror::Class& clazz,
                     art::mirror::Object& object, art::ArtField& field, PrintCommand::Options& options);
     static std::string FormatSize(uint64_t size);
@@ -16,6 +16,7 @@
 
 #include "logger/log.h"
 #include "android.h"
+#include "heap/heap_graph.h"
 #include "command/command_manager.h"
 #include "command/android/cmd_print.h"
 #include "command/android/cmd_search.h"
@@ -141,12 +142,26 @@ int SearchCommand::prepare(int argc, char* const argv[]) {
     }
 
     Android::Prepare();
+    if (options.reference && options.show)
+        android::HeapGraph::Get();
     return Command::ONCHLD;
 }
 
 int SearchCommand::main(int argc, char* const argv[]) {
     const char* classname = argv[options.optind];
 
+    object_verdicts.clear();
+    class_verdicts.clear();
+    pattern.reset();
+    if (options.regex) {
+        try {
+            pattern = std::make_unique<std::regex>(classname);
+        } catch (std::regex_error& e) {
+            LOGE("Invalid regex %s, %s\n", classname, e.what());
+            return 0;
+        }
+    }
+
     auto callback = [&](art::mirror::Object& object) -> bool {
         return SearchObjects(classname, object);
     };
@@ -163,28 +178,43 @@ int SearchCommand::main(int argc, char* const argv[]) {
     return 0;
 }
 
-bool SearchCommand::SearchObjects(const char* classsname, art::mirror::Object& object) {
-    int mask = object.IsClass() ? SEARCH_CLASS : SEARCH_OBJECT;
-    if (!(options.type_flag & mask))
-        return false;
-
-    std::string descriptor;
+SearchCommand::Verdict& SearchCommand::GetVerdict(const char* classsname, art::mirror::Object& object) {
     art::mirror::Class thiz = 0x0;
-    if (object.IsClass()) {
+    bool is_class = object.IsClass();
+    if (is_class) {
         thiz = object;
     } else {
         thiz = object.GetClass();
     }
-    descriptor = thiz.PrettyDescriptor();
 
+    std::unordered_map<uint64_t, Verdict>& verdicts = is_class ? class_verdicts : object_verdicts;
+    const auto& it = verdicts.find(thiz.Ptr());
+    if (it != verdicts.end())
+        return it->second;
+
+    Verdict verdict;
+    verdict.descriptor = thiz.PrettyDescriptor();
+
+    // class objects also match by java.lang.Class hierarchy, so
+    // they are kept apart from instances of the same class.
     java::lang::Object java = object;
-    if (options.regex && std::regex_search(descriptor, std::regex(classsname))
-            || descriptor == classsname
+    verdict.match = (pattern && std::regex_search(verdict.descriptor, *pattern))
+            || verdict.descriptor == classsname
             || (options.instof && (java.instanceof(classsname)
-                                || java.mirror_instanceof(classsname)))) {
+                                || java.mirror_instanceof(classsname)));
+    return verdicts.emplace(thiz.Ptr(), std::move(verdict)).first->second;
+}
+
+bool SearchCommand::SearchObjects(const char* classsname, art::mirror::Object& object) {
+    int mask = object.IsClass() ? SEARCH_CLASS : SEARCH_OBJECT;
+    if (!(options.type_flag & mask))
+        return false;
+
+    Verdict& verdict = GetVerdict(classsname, object);
+    if (verdict.match) {
         options.total_objects++;
         LOGI("[%" PRId64 "] " ANSI_COLOR_LIGHTYELLOW  "0x%" PRIx64 "" ANSI_COLOR_LIGHTCYAN " %s\n" ANSI_COLOR_RESET,
-                options.total_objects, object.Ptr(), descriptor.c_str());
+                options.total_objects, object.Ptr(), verdict.descriptor.c_str());
         if (options.show) {
             PrintCommand::Options print_options = {
                 .reference = options.reference,
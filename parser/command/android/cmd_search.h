@@ -19,6 +19,10 @@
 
 #include "command/command.h"
 #include "runtime/mirror/object.h"
+#include <string>
+#include <regex>
+#include <memory>
+#include <unordered_map>
 
 class SearchCommand : public Command {
 public:
@@ -41,12 +45,22 @@ public:
         int deep                = 0;
     };
 
+    struct Verdict {
+        bool match;
+        std::string descriptor;
+    };
+
     int main(int argc, char* const argv[]);
     int prepare(int argc, char* const argv[]);
     void usage();
     bool SearchObjects(const char* classsname, art::mirror::Object& object);
+    Verdict& GetVerdict(const char* classsname, art::mirror::Object& object);
 private:
     Options options;
+    std::unique_ptr<std::regex> pattern;
+    // resolve once per distinct class, object walk only lookup by pointer
+    std::unordered_map<uint64_t, Verdict> object_verdicts;
+    std::unordered_map<uint64_t, Verdict> class_verdicts;
 };
 
 #endif // PARSER_COMMAND_ANDROID_CMD_SEARCH_H_
@@ -23,13 +23,16 @@
 #include "libcore/util/NativeAllocationRegistry.h"
 #include "api/core.h"
 #include "android.h"
+#include "heap/heap_graph.h"
+#include "heap/dominator_tree.h"
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
 #include <sstream>
 #include <regex>
-#include <map>
+#include <algorithm>
 #include <vector>
+#include <mutex>
 
 int TopCommand::prepare(int argc, char* const argv[]) {
     if (!CoreApi::IsReady()
@@ -42,6 +45,7 @@ int TopCommand::prepare(int argc, char* const argv[]) {
     options.show = false;
     options.obj_each_flags = 0;
     options.ref_each_flags = 0;
+    options.json = false;
 
     int opt;
     int option_index = 0;
@@ -50,7 +54,9 @@ int TopCommand::prepare(int argc, char* const argv[]) {
         {"alloc",      no_argument,       0,  'a'},
         {"shallow",    no_argument,       0,  's'},
         {"native",     no_argument,       0,  'n'},
+        {"retained",   no_argument,       0,  'r'},
         {"display",    no_argument,       0,  'd'},
+        {"json",       no_argument,       0,  'j'},
         {"app",        no_argument,       0,   1 },
         {"zygote",     no_argument,       0,   2 },
         {"image",      no_argument,       0,   3 },
@@ -62,7 +68,7 @@ int TopCommand::prepare(int argc, char* const argv[]) {
         {0,            0,                 0,   0 },
     };
 
-    while ((opt = getopt_long(argc, argv, "asndt:",
+    while ((opt = getopt_long(argc, argv, "asnrdjt:",
                 long_options, &option_index)) != -1) {
         switch (opt) {
             case 'a':
@@ -74,9 +80,15 @@ int TopCommand::prepare(int argc, char* const argv[]) {
             case 'n':
                 options.order = ORDERBY_NATIVE;
                 break;
+            case 'r':
+                options.order = ORDERBY_RETAINED;
+                break;
             case 'd':
                 options.show = true;
                 break;
+            case 'j':
+                options.json = true;
+                break;
             case 1:
                 options.obj_each_flags |= Android::EACH_APP_OBJECTS;
                 break;
@@ -114,152 +126,268 @@ int TopCommand::prepare(int argc, char* const argv[]) {
     }
 
     Android::Prepare();
+    if (options.order == ORDERBY_RETAINED) {
+        // build in parent, later commands reuse it.
+        android::HeapGraph::Get()->GetDominatorTree();
+    }
     return Command::ONCHLD;
 }
 
-int TopCommand::main(int argc, char* const argv[]) {
-    std::map<art::mirror::Class, TopCommand::Pair> classes;
-    art::mirror::Class cleaner = 0;
-    std::vector<art::mirror::Object> cleaners;
-    auto callback = [&](art::mirror::Object& object) -> bool {
-        if (object.IsClass())
-            return false;
+static inline uint64_t HashClass(uint32_t klass) {
+    return static_cast<uint64_t>(klass) * 0x9E3779B97F4A7C15ULL;
+}
 
-        art::mirror::Class thiz = object.GetClass();
-        if (!cleaner.Ptr()) {
-            if (thiz.PrettyDescriptor() == "sun.misc.Cleaner") {
-                cleaner = thiz;
-                cleaners.push_back(object);
-            }
-        } else if (cleaner == thiz) {
-            cleaners.push_back(object);
-        }
+TopCommand::ClassTable::Entry& TopCommand::ClassTable::Get(uint32_t klass) {
+    if (!slots.size() || (count + 1) * 10 > slots.size() * 7)
+        Grow();
 
-        auto it = classes.find(thiz.Ptr());
-        if (it == classes.end()) {
-            TopCommand::Pair pair = {
-                .alloc_count = 1,
-                .shallow_size = object.SizeOf(),
-            };
-            classes.insert(std::pair<art::mirror::Class, TopCommand::Pair>(thiz, pair));
-        } else {
-            TopCommand::Pair& pair = it->second;
-            pair.alloc_count += 1;
-            pair.shallow_size += object.SizeOf();
-        }
+    uint64_t mask = slots.size() - 1;
+    uint64_t index = (HashClass(klass) >> 32) & mask;
+    while (slots[index].klass) {
+        if (slots[index].klass == klass)
+            return slots[index];
+        index = (index + 1) & mask;
+    }
+    count++;
+    Entry& entry = slots[index];
+    entry.klass = klass;
+    return entry;
+}
 
-        return false;
-    };
+void TopCommand::ClassTable::Grow() {
+    std::vector<Entry> old;
+    old.swap(slots);
+    Entry empty;
+    memset(&empty, 0x0, sizeof(Entry));
+    slots.resize(old.size() ? old.size() * 2 : kMinCapacity, empty);
 
-    try {
-        if (!options.ref_each_flags) {
-            Android::ForeachObjects(callback, options.obj_each_flags, false);
-        } else {
-            Android::ForeachReferences(callback, options.ref_each_flags);
-        }
-    } catch(InvalidAddressException& e) {
-        LOGW("The statistical process was interrupted!\n");
+    uint64_t mask = slots.size() - 1;
+    for (const auto& entry : old) {
+        if (!entry.klass)
+            continue;
+        uint64_t index = (HashClass(entry.klass) >> 32) & mask;
+        while (slots[index].klass)
+            index = (index + 1) & mask;
+        slots[index] = entry;
     }
+}
 
-    LOGI(ANSI_COLOR_LIGHTRED "Address       Allocations      ShallowSize        NativeSize     %s\n" ANSI_COLOR_RESET, options.show ? "ClassName" : "");
-    art::mirror::Class cur_max_thiz = 0;
-    TopCommand::Pair cur_max_pair = {
-        .alloc_count = 0,
-        .shallow_size = 0,
-        .native_size = 0,
-    };
+void TopCommand::ClassTable::Merge(ClassTable& other) {
+    for (const auto& value : other.slots) {
+        if (!value.klass)
+            continue;
+        Entry& entry = Get(value.klass);
+        if (entry.kind == KIND_UNKNOWN)
+            entry.kind = value.kind;
+        entry.pair.alloc_count += value.pair.alloc_count;
+        entry.pair.shallow_size += value.pair.shallow_size;
+        entry.pair.native_size += value.pair.native_size;
+        entry.pair.retained_size += value.pair.retained_size;
+    }
+}
 
-    for (int i = 0; i < cleaners.size(); i++) {
-        sun::misc::Cleaner cleaner = cleaners[i];
-        java::lang::Object referent = cleaner.getReferent();
+void TopCommand::Collect(ClassTable& table, int obj_each_flags, int ref_each_flags) {
+    // field lookups by name fill shared caches, take the lock for descriptors and Cleaner fields.
+    std::mutex descriptor_lock;
+    auto callback = [&](art::mirror::Object& object, ClassTable& partial) {
+        if (object.IsClass())
+            return;
 
-        if (referent.isNull())
-            continue;
+        art::mirror::Class thiz = object.GetClass();
+        ClassTable::Entry& entry = partial.Get(thiz.Ptr());
+        entry.pair.alloc_count += 1;
+        entry.pair.shallow_size += object.SizeOf();
 
-        auto it = classes.find(referent.klass());
-        if (it == classes.end())
-            continue;
+        if (entry.kind == ClassTable::KIND_OBJECT)
+            return;
+
+        std::lock_guard<std::mutex> guard(descriptor_lock);
+        if (entry.kind == ClassTable::KIND_UNKNOWN) {
+            entry.kind = thiz.PrettyDescriptor() == "sun.misc.Cleaner"
+                       ? ClassTable::KIND_CLEANER : ClassTable::KIND_OBJECT;
+            if (entry.kind == ClassTable::KIND_OBJECT)
+                return;
+        }
 
+        // entry may move below, don't touch it again.
         try {
+            sun::misc::Cleaner cleaner = object;
+            java::lang::Object referent = cleaner.getReferent();
+            if (referent.isNull())
+                return;
+
             libcore::util::NativeAllocationRegistry::CleanerThunk thunk = cleaner.getThunk();
             if (thunk.isNull())
-                continue;
+                return;
 
             libcore::util::NativeAllocationRegistry registry = thunk.getRegistry();
             if (registry.isNull())
-                continue;
+                return;
 
-            TopCommand::Pair& pair = it->second;
-            pair.native_size += registry.getSize();
+            partial.Get(referent.klass().Ptr()).pair.native_size += registry.getSize();
         } catch (InvalidAddressException& e) {}
+    };
+
+    std::vector<ClassTable> partials;
+    try {
+        if (!ref_each_flags) {
+            Android::ParallelForeachObjects<ClassTable>(partials, callback, obj_each_flags, false);
+        } else {
+            partials.resize(1);
+            auto refcallback = [&](art::mirror::Object& object) -> bool {
+                callback(object, partials[0]);
+                return false;
+            };
+            Android::ForeachReferences(refcallback, ref_each_flags);
+        }
+    } catch(InvalidAddressException& e) {
+        LOGW("The statistical process was interrupted!\n");
     }
 
-    uint64_t total_count = 0;
-    uint64_t total_shallow = 0;
-    uint64_t total_native = 0;
+    for (auto& partial : partials)
+        table.Merge(partial);
+}
+
+static std::string JsonEscape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 16);
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+int TopCommand::main(int argc, char* const argv[]) {
+    ClassTable table;
+    Collect(table, options.obj_each_flags, options.ref_each_flags);
+
+    bool retained = options.order == ORDERBY_RETAINED;
+    android::DominatorTree* tree = retained ? android::HeapGraph::Get()->GetDominatorTree() : nullptr;
+
+    // Cleaner referents outside the walked objects only have a native size, drop them.
+    TopCommand::Pair total = {0, 0, 0, 0};
+    std::vector<ClassTable::Entry*> entries;
+    entries.reserve(table.size());
+    for (auto& entry : table.GetSlots()) {
+        if (!entry.klass || !entry.pair.alloc_count)
+            continue;
+        if (retained)
+            entry.pair.retained_size = tree->GetClassRetained(entry.klass);
+        total.alloc_count += entry.pair.alloc_count;
+        total.shallow_size += entry.pair.shallow_size;
+        total.native_size += entry.pair.native_size;
+        entries.push_back(&entry);
+    }
 
-    for (const auto& value : classes) {
-        const art::mirror::Class& thiz = value.first;
-        const TopCommand::Pair& pair = value.second;
+    auto key = [&](const ClassTable::Entry* entry) -> uint64_t {
+        switch (options.order) {
+            case ORDERBY_SHALLOW: return entry->pair.shallow_size;
+            case ORDERBY_NATIVE: return entry->pair.native_size;
+            case ORDERBY_RETAINED: return entry->pair.retained_size;
+            default: return entry->pair.alloc_count;
+        }
+    };
+    auto greater = [&](const ClassTable::Entry* a, const ClassTable::Entry* b) {
+        uint64_t ka = key(a);
+        uint64_t kb = key(b);
+        if (ka != kb)
+            return ka > kb;
+        return a->klass > b->klass;
+    };
+    uint64_t num = options.num > 0 ? std::min<uint64_t>(options.num, entries.size()) : entries.size();
+    std::partial_sort(entries.begin(), entries.begin() + num, entries.end(), greater);
+    entries.resize(num);
 
-        total_count += pair.alloc_count;
-        total_shallow += pair.shallow_size;
-        total_native += pair.native_size;
+    uint64_t reachable = retained ? tree->GetReachableSize() : 0;
+    if (options.json) {
+        ShowJson(entries, total, reachable);
+    } else {
+        ShowText(entries, total, reachable);
     }
+    return 0;
+}
 
-    LOGI("TOTAL            " ANSI_COLOR_LIGHTMAGENTA "%8" PRId64 "      " ANSI_COLOR_LIGHTBLUE "%11" PRId64 "       " ANSI_COLOR_LIGHTGREEN "%11" PRId64 "\n" ANSI_COLOR_RESET,
-         total_count, total_shallow, total_native);
+void TopCommand::ShowText(std::vector<ClassTable::Entry*>& entries, Pair& total, uint64_t reachable) {
+    bool retained = options.order == ORDERBY_RETAINED;
+    LOGI(ANSI_COLOR_LIGHTRED "Address       Allocations      ShallowSize        NativeSize     %s%s\n" ANSI_COLOR_RESET,
+         retained ? " RetainedSize     " : "", options.show ? "ClassName" : "");
+    if (retained) {
+        // classes nest, the total is everything the roots keep alive.
+        LOGI("TOTAL            " ANSI_COLOR_LIGHTMAGENTA "%8" PRId64 "      " ANSI_COLOR_LIGHTBLUE "%11" PRId64 "       " ANSI_COLOR_LIGHTGREEN "%11" PRId64 "       " ANSI_COLOR_LIGHTRED "%11" PRId64 "\n" ANSI_COLOR_RESET,
+             total.alloc_count, total.shallow_size, total.native_size, reachable);
+    } else {
+        LOGI("TOTAL            " ANSI_COLOR_LIGHTMAGENTA "%8" PRId64 "      " ANSI_COLOR_LIGHTBLUE "%11" PRId64 "       " ANSI_COLOR_LIGHTGREEN "%11" PRId64 "\n" ANSI_COLOR_RESET,
+             total.alloc_count, total.shallow_size, total.native_size);
+    }
     LOGI("------------------------------------------------------------\n");
 
-    for (int i = 0; i < options.num; ++i) {
-        for (const auto& value : classes) {
-            const art::mirror::Class& thiz = value.first;
-            const TopCommand::Pair& pair = value.second;
-
-            switch (options.order) {
-                case ORDERBY_ALLOC: {
-                   if (pair.alloc_count >= cur_max_pair.alloc_count) {
-                       cur_max_thiz = thiz;
-                       cur_max_pair = pair;
-                   }
-                } break;
-                case ORDERBY_SHALLOW: {
-                   if (pair.shallow_size >= cur_max_pair.shallow_size) {
-                       cur_max_thiz = thiz;
-                       cur_max_pair = pair;
-                   }
-                } break;
-                case ORDERBY_NATIVE: {
-                   if (pair.native_size >= cur_max_pair.native_size) {
-                       cur_max_thiz = thiz;
-                       cur_max_pair = pair;
-                   }
-                } break;
-            }
+    for (const auto& entry : entries) {
+        art::mirror::Class thiz = entry->klass;
+        const TopCommand::Pair& pair = entry->pair;
+        if (retained) {
+            LOGI(ANSI_COLOR_LIGHTYELLOW "0x%08" PRIx64 "" ANSI_COLOR_RESET "       " "%8" PRId64 "      " "%11" PRId64 "       " "%11" PRId64 "       " "%11" PRId64 "     " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
+                 thiz.Ptr(), pair.alloc_count, pair.shallow_size, pair.native_size, pair.retained_size,
+                 options.show ? thiz.PrettyDescriptor().c_str() : "");
+        } else {
+            LOGI(ANSI_COLOR_LIGHTYELLOW "0x%08" PRIx64 "" ANSI_COLOR_RESET "       " "%8" PRId64 "      " "%11" PRId64 "       " "%11" PRId64 "     " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
+                 thiz.Ptr(), pair.alloc_count, pair.shallow_size, pair.native_size,
+                 options.show ? thiz.PrettyDescriptor().c_str() : "");
         }
+    }
+}
 
-        if (!cur_max_thiz.Ptr())
-            break;
-
-        LOGI(ANSI_COLOR_LIGHTYELLOW "0x%08" PRIx64 "" ANSI_COLOR_RESET "       " "%8" PRId64 "      " "%11" PRId64 "       " "%11" PRId64 "     " ANSI_COLOR_LIGHTCYAN "%s\n" ANSI_COLOR_RESET,
-             cur_max_thiz.Ptr(), cur_max_pair.alloc_count,
-             cur_max_pair.shallow_size, cur_max_pair.native_size,
-             options.show ? cur_max_thiz.PrettyDescriptor().c_str() : "");
+/*
+ * newline delimited json, every line is a complete object so a consumer can
+ * stream it. the first line carries the totals, then one line per class.
+ *
+ * {"total":{"count":N,"shallow":N,"native":N[,"retained":N]}}
+ * {"address":"0x..","count":N,"shallow":N,"native":N[,"retained":N],"name":"..."}
+ * ...
+ */
+void TopCommand::ShowJson(std::vector<ClassTable::Entry*>& entries, Pair& total, uint64_t reachable) {
+    bool retained = options.order == ORDERBY_RETAINED;
+    if (retained) {
+        LOGI("{\"total\":{\"count\":%" PRId64 ",\"shallow\":%" PRId64 ",\"native\":%" PRId64 ",\"retained\":%" PRId64 "}}\n",
+             total.alloc_count, total.shallow_size, total.native_size, reachable);
+    } else {
+        LOGI("{\"total\":{\"count\":%" PRId64 ",\"shallow\":%" PRId64 ",\"native\":%" PRId64 "}}\n",
+             total.alloc_count, total.shallow_size, total.native_size);
+    }
 
-        classes.erase(cur_max_thiz);
-        cur_max_thiz = 0;
-        cur_max_pair = {0, 0, 0};
+    for (const auto& entry : entries) {
+        art::mirror::Class thiz = entry->klass;
+        const TopCommand::Pair& pair = entry->pair;
+        std::string name = JsonEscape(thiz.PrettyDescriptor());
+        if (retained) {
+            LOGI("{\"address\":\"0x%" PRIx64 "\",\"count\":%" PRId64 ",\"shallow\":%" PRId64 ",\"native\":%" PRId64 ",\"retained\":%" PRId64 ",\"name\":\"%s\"}\n",
+                 thiz.Ptr(), pair.alloc_count, pair.shallow_size, pair.native_size, pair.retained_size, name.c_str());
+        } else {
+            LOGI("{\"address\":\"0x%" PRIx64 "\",\"count\":%" PRId64 ",\"shallow\":%" PRId64 ",\"native\":%" PRId64 ",\"name\":\"%s\"}\n",
+                 thiz.Ptr(), pair.alloc_count, pair.shallow_size, pair.native_size, name.c_str());
+        }
     }
-    return 0;
 }
 
 void TopCommand::usage() {
-    LOGI("Usage: top <NUM> [OPTION] [TYPE] [REF]\n");
+    LOGI("Usage: top <NUM> [OPTION] [TYPE] [REF], NUM <= 0 shows all classes\n");
     LOGI("Option:\n");
     LOGI("    -a, --alloc     order by allocation\n");
     LOGI("    -s, --shallow   order by shallow\n");
     LOGI("    -n, --native    order by native\n");
+    LOGI("    -r, --retained  order by retained, whole heap dominator tree\n");
     LOGI("    -d, --display   show class name\n");
+    LOGI("    -j, --json      ndjson, a totals line then one object per class\n");
     LOGI("Type: {--app, --zygote, --image, --fake}\n");
     LOGI("Ref: {--local, --global, --weak, --thread <TID>}\n");
     ENTER();
@@ -20,12 +20,14 @@
 #include "command/command.h"
 #include "runtime/mirror/object.h"
 #include "android.h"
+#include <vector>
 
 class TopCommand : public Command {
 public:
     static constexpr int ORDERBY_ALLOC = 1 << 0;
     static constexpr int ORDERBY_SHALLOW = 1 << 1;
     static constexpr int ORDERBY_NATIVE = 1 << 2;
+    static constexpr int ORDERBY_RETAINED = 1 << 3;
 
     TopCommand() : Command("top") {}
     ~TopCommand() {}
@@ -36,6 +38,7 @@ public:
         bool show;
         int obj_each_flags;
         int ref_each_flags;
+        bool json;
     };
 
     int main(int argc, char* const argv[]);
@@ -47,7 +50,40 @@ public:
         uint64_t alloc_count;
         uint64_t shallow_size;
         uint64_t native_size;
+        uint64_t retained_size;
     };
+
+    /*
+     * class -> Pair, open addressing with linear probing, a class pointer
+     * is never 0 so 0 marks a free slot. One table per worker, merged after.
+     */
+    class ClassTable {
+    public:
+        static constexpr uint64_t kMinCapacity = 1024;
+        static constexpr uint32_t KIND_UNKNOWN = 0;
+        static constexpr uint32_t KIND_OBJECT = 1;
+        static constexpr uint32_t KIND_CLEANER = 2;
+
+        struct Entry {
+            uint32_t klass;
+            uint32_t kind;
+            Pair pair;
+        };
+
+        Entry& Get(uint32_t klass);
+        void Merge(ClassTable& other);
+        uint64_t size() { return count; }
+        std::vector<Entry>& GetSlots() { return slots; }
+    private:
+        void Grow();
+        uint64_t count = 0;
+        std::vector<Entry> slots;
+    };
+
+    // one heap walk, sun.misc.Cleaner native sizes go to their referent's class.
+    static void Collect(ClassTable& table, int obj_each_flags, int ref_each_flags);
+    void ShowText(std::vector<ClassTable::Entry*>& entries, Pair& total, uint64_t reachable);
+    void ShowJson(std::vector<ClassTable::Entry*>& entries, Pair& total, uint64_t reachable);
 private:
     Options options;
 };
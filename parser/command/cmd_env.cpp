@@ -21,13 +21,16 @@
 #include "command/env.h"
 #include "api/core.h"
 #include "api/elf.h"
+#include "api/symbol_cache.h"
 #include "common/elf.h"
 #include "common/disassemble/capstone.h"
 #include "base/utils.h"
 #include "base/macros.h"
+#include "base/thread_pool.h"
 #include <linux/elf.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <vector>
 
 typedef int (*EnvCall)(int argc, char* const argv[]);
 struct EnvOption {
@@ -73,10 +76,12 @@ int EnvCommand::onConfigChanged(int argc, char* const argv[]) {
         {"pid",     required_argument, 0, 'p'},
         {"sdk",     required_argument, 0,  0 },
         {"oat",     required_argument, 0,  1 },
+        {"thread",  required_argument, 0, 't'},
+        {"cache",   required_argument, 0,  2 },
         {0,         0,                 0,  0 },
     };
 
-    while ((opt = getopt_long(argc, argv, "p:0:1:",
+    while ((opt = getopt_long(argc, argv, "p:0:1:t:2:",
                 long_options, &option_index)) != -1) {
         switch (opt) {
             case 'p':
@@ -96,6 +101,14 @@ int EnvCommand::onConfigChanged(int argc, char* const argv[]) {
                     Android::OnOatChanged(current_oat);
                 }
                 break;
+            case 't':
+                ThreadPool::SetThreads(std::atoi(optarg));
+                LOGI("Switch parallel walk threads(%d).\n", ThreadPool::GetThreads());
+                break;
+            case 2:
+                SymbolCache::SetDir(optarg);
+                LOGI("Switch symbol cache dir(%s).\n", SymbolCache::GetDir().c_str());
+                break;
         }
     }
 
@@ -333,7 +346,14 @@ int EnvCommand::clocLoadCRC32(int num) {
     if (!CoreApi::IsReady())
         return 0;
 
-    bool first = true;
+    struct VerifyBlock {
+        int index;
+        LoadBlock* block;
+        uint32_t or_crc;
+        uint32_t mmap_crc;
+    };
+    std::vector<VerifyBlock> blocks;
+
     int index = 0;
     auto callback = [&](LoadBlock *block) -> bool {
         index++;
@@ -347,67 +367,73 @@ int EnvCommand::clocLoadCRC32(int num) {
         // if (!(block->flags() & Block::FLAG_X))
         //    return false;
 
-        if (cloc_all || num == index) {
-            uint32_t or_crc = 0x0;
-            uint32_t mmap_crc = 0x0;
-
-            ElfHeader* header = reinterpret_cast<ElfHeader*>(block->begin(LoadBlock::OPT_READ_MMAP));
-            if (!memcmp(header->ident, ELFMAG, 4)) {
-                // skip elf header
-                or_crc = Utils::CRC32(reinterpret_cast<uint8_t*>(block->begin(LoadBlock::OPT_READ_OR)) + SIZEOF(Elfx_Ehdr),
-                        block->size(LoadBlock::OPT_READ_OR) - SIZEOF(Elfx_Ehdr));
-                mmap_crc = Utils::CRC32(reinterpret_cast<uint8_t*>(block->begin(LoadBlock::OPT_READ_MMAP)) + SIZEOF(Elfx_Ehdr),
-                        block->size(LoadBlock::OPT_READ_MMAP) - SIZEOF(Elfx_Ehdr));
-            } else {
-                or_crc = block->GetCRC32(LoadBlock::OPT_READ_OR);
-                mmap_crc = block->GetCRC32(LoadBlock::OPT_READ_MMAP);
-            }
+        blocks.push_back({index, block, 0x0, 0x0});
+        return false;
+    };
+    CoreApi::ForeachLoadBlock(callback, false);
 
-            if (or_crc != mmap_crc) {
-                std::string name;
-                name.append(Logger::Green());
-                name.append(block->name());
-                name.append(Logger::End());
-
-                if (!first) { ENTER(); }
-                first = false;
-                LOGI("%-5d " ANSI_COLOR_CYAN "[%" PRIx64 ", %" PRIx64 ")" ANSI_COLOR_RESET "  %s  %010" PRIx64 "  ""%s""\n",
-                        index, block->vaddr(), block->vaddr() + block->memsz(), block->convertFlags().c_str(),
-                        block->realSize(), name.c_str());
-
-                uint64_t* orv = reinterpret_cast<uint64_t*>(block->begin(LoadBlock::OPT_READ_OR));
-                uint64_t* mmv = reinterpret_cast<uint64_t*>(block->begin(LoadBlock::OPT_READ_MMAP));
-                int count = RoundUp(block->size(LoadBlock::OPT_READ_OR) / 8, 2);
-                LinkMap::NiceSymbol symbol;
-                for (int k = 0; k < count; k += 2) {
-                    uint64_t orv1 = orv[k];
-                    uint64_t orv2 = orv[k + 1];
-                    uint64_t mmv1 = mmv[k];
-                    uint64_t mmv2 = mmv[k + 1];
-                    if (LIKELY(orv1 == mmv1) && LIKELY(orv2 == mmv2))
-                        continue;
-
-                    uint64_t current = block->vaddr() + k * 8;
-                    if (!symbol.IsValid() ||
-                            (current < symbol.GetOffset() ||
-                             current >= symbol.GetOffset() + symbol.GetSize())) {
-                        if (block->handle()) {
-                            symbol = LinkMap::NiceSymbol::Invalid();
-                            block->handle()->NiceMethod(current, symbol);
-                            if (symbol.IsValid()) LOGI(ANSI_COLOR_YELLOW "%s" ANSI_COLOR_RESET ":\n", symbol.GetSymbol().c_str());
-                        }
+    // blocks are independent, checksum them together.
+    ThreadPool::ParallelFor(blocks.size(), [&](uint64_t idx, int worker) {
+        VerifyBlock& verify = blocks[idx];
+        LoadBlock* block = verify.block;
+        ElfHeader* header = reinterpret_cast<ElfHeader*>(block->begin(LoadBlock::OPT_READ_MMAP));
+        if (!memcmp(header->ident, ELFMAG, 4)) {
+            // skip elf header
+            verify.or_crc = Utils::CRC32(reinterpret_cast<uint8_t*>(block->begin(LoadBlock::OPT_READ_OR)) + SIZEOF(Elfx_Ehdr),
+                    block->size(LoadBlock::OPT_READ_OR) - SIZEOF(Elfx_Ehdr));
+            verify.mmap_crc = Utils::CRC32(reinterpret_cast<uint8_t*>(block->begin(LoadBlock::OPT_READ_MMAP)) + SIZEOF(Elfx_Ehdr),
+                    block->size(LoadBlock::OPT_READ_MMAP) - SIZEOF(Elfx_Ehdr));
+        } else {
+            verify.or_crc = block->GetCRC32(LoadBlock::OPT_READ_OR);
+            verify.mmap_crc = block->GetCRC32(LoadBlock::OPT_READ_MMAP);
+        }
+    });
+
+    bool first = true;
+    for (const auto& verify : blocks) {
+        LoadBlock* block = verify.block;
+        if (verify.or_crc != verify.mmap_crc) {
+            std::string name;
+            name.append(Logger::Green());
+            name.append(block->name());
+            name.append(Logger::End());
+
+            if (!first) { ENTER(); }
+            first = false;
+            LOGI("%-5d " ANSI_COLOR_CYAN "[%" PRIx64 ", %" PRIx64 ")" ANSI_COLOR_RESET "  %s  %010" PRIx64 "  ""%s""\n",
+                    verify.index, block->vaddr(), block->vaddr() + block->memsz(), block->convertFlags().c_str(),
+                    block->realSize(), name.c_str());
+
+            uint64_t* orv = reinterpret_cast<uint64_t*>(block->begin(LoadBlock::OPT_READ_OR));
+            uint64_t* mmv = reinterpret_cast<uint64_t*>(block->begin(LoadBlock::OPT_READ_MMAP));
+            int count = RoundUp(block->size(LoadBlock::OPT_READ_OR) / 8, 2);
+            LinkMap::NiceSymbol symbol;
+            for (int k = 0; k < count; k += 2) {
+                uint64_t orv1 = orv[k];
+                uint64_t orv2 = orv[k + 1];
+                uint64_t mmv1 = mmv[k];
+                uint64_t mmv2 = mmv[k + 1];
+                if (LIKELY(orv1 == mmv1) && LIKELY(orv2 == mmv2))
+                    continue;
+
+                uint64_t current = block->vaddr() + k * 8;
+                if (!symbol.IsValid() ||
+                        (current < symbol.GetOffset() ||
+                         current >= symbol.GetOffset() + symbol.GetSize())) {
+                    if (block->handle()) {
+                        symbol = LinkMap::NiceSymbol::Invalid();
+                        block->handle()->NiceMethod(current, symbol);
+                        if (symbol.IsValid()) LOGI(ANSI_COLOR_YELLOW "%s" ANSI_COLOR_RESET ":\n", symbol.GetSymbol().c_str());
                     }
-                    LOGI(ANSI_COLOR_CYAN "%" PRIx64 "" ANSI_COLOR_RESET ": %016" PRIx64 "  %016" PRIx64 "  %s%s  |  %016" PRIx64 "  %016" PRIx64 "  %s%s\n",
-                            current, orv1, orv2,
-                            Utils::ConvertAscii(orv1, 8).c_str(), Utils::ConvertAscii(orv2, 8).c_str(),
-                            mmv1, mmv2,
-                            Utils::ConvertAscii(mmv1, 8).c_str(), Utils::ConvertAscii(mmv2, 8).c_str());
                 }
+                LOGI(ANSI_COLOR_CYAN "%" PRIx64 "" ANSI_COLOR_RESET ": %016" PRIx64 "  %016" PRIx64 "  %s%s  |  %016" PRIx64 "  %016" PRIx64 "  %s%s\n",
+                        current, orv1, orv2,
+                        Utils::ConvertAscii(orv1, 8).c_str(), Utils::ConvertAscii(orv2, 8).c_str(),
+                        mmv1, mmv2,
+                        Utils::ConvertAscii(mmv1, 8).c_str(), Utils::ConvertAscii(mmv2, 8).c_str());
             }
         }
-        return false;
-    };
-    CoreApi::ForeachLoadBlock(callback, false);
+    }
     return 0;
 }
 
@@ -442,6 +468,8 @@ void EnvCommand::usage() {
     LOGI("        --sdk <VERSION>   set current sdk version\n");
     LOGI("        --oat <VERSION>   set current oat version\n");
     LOGI("    -p, --pid <PID>       set current thread\n");
+    LOGI("    -t, --thread <NUM>    set parallel walk threads, 0 is cpu count\n");
+    LOGI("        --cache <DIR>     set symbol cache dir keyed by build-id, \"\" disables\n");
     ENTER();
     LOGI("core-parser> env config --sdk 30\n");
     LOGI("Switch android(30) env.\n");
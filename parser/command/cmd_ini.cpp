@@ -73,6 +73,7 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <filesystem>
+#include <set>
 #include <string>
 
 #define INI_ENTRY(NAME) {#NAME, &NAME}
@@ -541,11 +542,7 @@ IniCommand::IniCommand() : Command("ini") {
 
         auto& loader = map->GetDwarfLoader();
         if (!loader) return;
-        int total = 0;
-        loader->ForEachStruct([&](const dwarf::StructInfo& si) {
-            total += INSTANCE->ApplyDwarfStruct(si);
-            return false;
-        });
+        int total = INSTANCE->ApplyDwarfLoader(loader.get());
         if (total > 0) {
             LOGI("DWARF: applied %d entries from %s\n", total, map->name());
             Android::Reset();
@@ -1065,6 +1062,19 @@ static const DwarfBinding kDwarfBindings[] = {
     {"art::LengthPrefixedArray", "data_", &__LengthPrefixedArray_offset__.data_},
 };
 
+int IniCommand::ApplyDwarfLoader(dwarf::DwarfLoader* loader) {
+    int applied = 0;
+    std::set<std::string> done;
+    for (size_t i = 0; i < sizeof(kDwarfBindings) / sizeof(kDwarfBindings[0]); ++i) {
+        const char* name = kDwarfBindings[i].dwarf_class;
+        if (!done.insert(name).second)
+            continue;
+        const dwarf::StructInfo* si = loader->FindStruct(name);
+        if (si) applied += ApplyDwarfStruct(*si);
+    }
+    return applied;
+}
+
 int IniCommand::ApplyDwarfStruct(const dwarf::StructInfo& si) {
     int applied = 0;
     for (size_t i = 0; i < sizeof(kDwarfBindings) / sizeof(kDwarfBindings[0]); ++i) {
@@ -38,6 +38,7 @@ public:
     int main(int argc, char* const argv[]);
     int prepare(int argc, char* const argv[]);
     void usage();
+    int ApplyDwarfLoader(dwarf::DwarfLoader* loader);
     int ApplyDwarfStruct(const dwarf::StructInfo& si);
     static uint32_t OffsetValue(void* offset);
     static void SetValue(void* offset, uint32_t value);
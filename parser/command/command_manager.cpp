@@ -46,6 +46,8 @@
 #include "command/android/cmd_search.h"
 #include "command/android/cmd_class.h"
 #include "command/android/cmd_top.h"
+#include "command/android/cmd_gcroot.h"
+#include "command/android/cmd_histogram.h"
 #include "command/android/cmd_space.h"
 #include "command/android/cmd_dex.h"
 #include "command/android/cmd_method.h"
@@ -126,6 +128,8 @@ void CommandManager::Init() {
     CommandManager::PushInlineCommand(new SearchCommand());
     CommandManager::PushInlineCommand(new ClassCommand());
     CommandManager::PushInlineCommand(new TopCommand());
+    CommandManager::PushInlineCommand(new GcRootCommand());
+    CommandManager::PushInlineCommand(new HistogramCommand());
     CommandManager::PushInlineCommand(new SpaceCommand());
     CommandManager::PushInlineCommand(new DexCommand());
     CommandManager::PushInlineCommand(new MethodCommand());
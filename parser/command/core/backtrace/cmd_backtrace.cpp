@@ -19,6 +19,7 @@
 #include "api/unwind.h"
 #include "arm64/unwind.h"
 #include "base/utils.h"
+#include "base/thread_pool.h"
 #include "common/elf.h"
 #include "common/exception.h"
 #include "command/env.h"
@@ -31,6 +32,8 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <memory>
+#include <algorithm>
+#include <unordered_map>
 
 int BacktraceCommand::prepare(int argc, char* const argv[]) {
     if (!CoreApi::IsReady())
@@ -38,6 +41,7 @@ int BacktraceCommand::prepare(int argc, char* const argv[]) {
 
     options.dump_all = false;
     options.dump_detail = false;
+    options.dump_group = false;
     options.dump_fps.clear();
     options.threads.clear();
 
@@ -48,10 +52,11 @@ int BacktraceCommand::prepare(int argc, char* const argv[]) {
         {"all",    no_argument,       0,  'a'},
         {"detail", no_argument,       0,  'd'},
         {"fp",     required_argument, 0,  'f'},
+        {"group",  no_argument,       0,  'g'},
         {0,        0,                 0,   0 },
     };
 
-    while ((opt = getopt_long(argc, (char* const*)argv, "adf:",
+    while ((opt = getopt_long(argc, (char* const*)argv, "adf:g",
                 long_options, &option_index)) != -1) {
         switch (opt) {
             case 'a':
@@ -60,6 +65,9 @@ int BacktraceCommand::prepare(int argc, char* const argv[]) {
             case 'd':
                 options.dump_detail = true;
                 break;
+            case 'g':
+                options.dump_group = true;
+                break;
             case 'f': {
                 std::unique_ptr<char[], void(*)(void*)> newpath(strdup(optarg), free);
                 char *token = strtok(newpath.get(), ":");
@@ -120,7 +128,11 @@ int BacktraceCommand::main(int argc, char* const argv[]) {
 #endif
     }
 
-    DumpTrace();
+    if (options.dump_group) {
+        DumpGroups();
+    } else {
+        DumpTrace();
+    }
     return 0;
 }
 
@@ -159,9 +171,34 @@ BacktraceCommand::ThreadRecord* BacktraceCommand::findRecord(int pid) {
     return nullptr;
 }
 
+/*
+ * Native stacks only read the core, with more than one worker they are
+ * unwound and symbolized in parallel into per-thread buffers. The java
+ * side caches mirror state without locks, it still runs in thread order
+ * when the buffers are printed.
+ */
+void BacktraceCommand::DumpNativeStacks(std::vector<std::string>& natives) {
+    api::UnwindStack::Prepare();
+    natives.resize(options.threads.size());
+    ThreadPool::ParallelFor(options.threads.size(), [&](uint64_t index, int worker) {
+        const auto& record = options.threads[index];
+        Logger::ScopedCapture capture(&natives[index]);
+        try {
+            DumpNativeStack(record->thread, record->api);
+        } catch(InvalidAddressException& e) {
+            LOGI(ANSI_COLOR_RED "  (STACK MAYBE INCOIMPLETE)\n" ANSI_COLOR_RESET);
+        }
+    });
+}
+
 void BacktraceCommand::DumpTrace() {
+    std::vector<std::string> natives;
+    if (options.threads.size() > 1 && ThreadPool::GetThreads() > 1)
+        DumpNativeStacks(natives);
+
     bool needEnd = false;
-    for (const auto& record : options.threads) {
+    for (uint64_t index = 0; index < options.threads.size(); ++index) {
+        const auto& record = options.threads[index];
         if (needEnd) ENTER();
 #if defined(__AOSP_PARSER__)
         if (record->thread) {
@@ -176,7 +213,11 @@ void BacktraceCommand::DumpTrace() {
 #else
         LOGI("Thread(\"" ANSI_COLOR_YELLOW "%d" ANSI_COLOR_RESET "\")\n", record->pid);
 #endif
-        DumpNativeStack(record->thread, record->api);
+        if (natives.size()) {
+            LOGI("%s", natives[index].c_str());
+        } else {
+            DumpNativeStack(record->thread, record->api);
+        }
 #if defined(__AOSP_PARSER__)
         try {
             DumpJavaStack(record->thread, record->api);
@@ -197,26 +238,160 @@ void BacktraceCommand::DumpNativeStack(void *thread, ThreadApi* api) {
     std::unique_ptr<api::UnwindStack> unwind_stack = api::UnwindStack::MakeUnwindStack(api);
     if (unwind_stack) {
         unwind_stack->WalkStack();
-        std::string format = FormatNativeFrame("  ", unwind_stack->GetNativeFrames().size());
-        uint32_t frameid = 0;
-        for (const auto& native_frame : unwind_stack->GetNativeFrames()) {
-            std::string method_desc = native_frame->GetMethodName();
-            uint64_t offset = (native_frame->GetFramePc() & CoreApi::GetVabitsMask()) - native_frame->GetMethodOffset();
-            if (offset && native_frame->GetMethodOffset())
-                method_desc.append("+").append(Utils::ToHex(offset));
+        DumpNativeFrames(unwind_stack.get());
+    }
+}
 
-            if (!method_desc.length() && native_frame->GetLinkMap()
-                    && native_frame->GetLinkMap()->begin()) {
-                method_desc.append(options.dump_detail ? native_frame->GetOrigin() : native_frame->GetLibrary());
-                method_desc.append("+").append(Utils::ToHex(offset-native_frame->GetLinkMap()->begin()));
+void BacktraceCommand::DumpNativeFrames(api::UnwindStack* unwind_stack) {
+    std::string format = FormatNativeFrame("  ", unwind_stack->GetNativeFrames().size());
+    std::string method_desc;
+    uint32_t frameid = 0;
+    for (const auto& native_frame : unwind_stack->GetNativeFrames()) {
+        method_desc.assign(native_frame->GetMethodName());
+        uint64_t offset = (native_frame->GetFramePc() & CoreApi::GetVabitsMask()) - native_frame->GetMethodOffset();
+        if (offset && native_frame->GetMethodOffset())
+            method_desc.append("+").append(Utils::ToHex(offset));
+
+        if (!method_desc.length() && native_frame->GetLinkMap()
+                && native_frame->GetLinkMap()->begin()) {
+            method_desc.append(options.dump_detail ? native_frame->GetOrigin() : native_frame->GetLibrary());
+            method_desc.append("+").append(Utils::ToHex(offset-native_frame->GetLinkMap()->begin()));
+        }
+        LOGI(format.c_str(), frameid, native_frame->GetFramePc(), method_desc.c_str());
+        ++frameid;
+        if (frameid == unwind_stack->GetContextNum()) {
+            LOGI(ANSI_COLOR_LIGHTRED "    <<maybe handle signal ucontext: 0x%" PRIx64 ">>\n" ANSI_COLOR_RESET, unwind_stack->GetContext());
+            unwind_stack->DumpContextRegister("  ");
+        }
+    }
+}
+
+void BacktraceCommand::DumpJavaFrames(art::StackVisitor* visitor) {
+    std::string format = FormatJavaFrame("  ", visitor->GetJavaFrames().size());
+    uint32_t frameid = 0;
+    for (const auto& java_frame : visitor->GetJavaFrames()) {
+        LOGI(format.c_str(), frameid, java_frame->GetDexPcPtr(),
+             options.dump_detail ? java_frame->GetMethod().ColorPrettyMethodOnlyNP().c_str()
+                         : java_frame->GetMethod().ColorPrettyMethodSimple().c_str());
+        ++frameid;
+    }
+}
+
+static uint64_t HashFrames(const std::vector<uint64_t>& frames) {
+    uint64_t hash = frames.size();
+    for (uint64_t value : frames)
+        hash = (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+    return hash;
+}
+
+/*
+ * Threads with the same native pcs and java (method, dex pc) sequence
+ * share one group. Stacks are walked once per thread, only the first
+ * thread of each group is symbolized and printed, most threads first.
+ */
+void BacktraceCommand::DumpGroups() {
+    struct StackGroup {
+        std::vector<uint64_t> frames;
+        std::vector<int> tids;
+        uint64_t first;     // index of the printed thread
+    };
+
+    uint64_t count = options.threads.size();
+    std::vector<std::unique_ptr<api::UnwindStack>> natives(count);
+    auto walk = [&](uint64_t index, int worker) {
+        ThreadApi* api = options.threads[index]->api;
+        if (!api)
+            return;
+        natives[index] = api::UnwindStack::MakeUnwindStack(api);
+        if (natives[index]) {
+            try {
+                natives[index]->WalkStack();
+            } catch(InvalidAddressException& e) {}
+        }
+    };
+    if (count > 1 && ThreadPool::GetThreads() > 1) {
+        api::UnwindStack::Prepare();
+        ThreadPool::ParallelFor(count, walk);
+    } else {
+        for (uint64_t index = 0; index < count; ++index)
+            walk(index, 0);
+    }
+
+    std::vector<StackGroup> groups;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> buckets;  // hash -> groups
+#if defined(__AOSP_PARSER__)
+    std::vector<std::unique_ptr<art::StackVisitor>> javas(count);
+#endif
+    uint64_t mask = CoreApi::GetVabitsMask();
+    for (uint64_t index = 0; index < count; ++index) {
+        const auto& record = options.threads[index];
+        std::vector<uint64_t> frames;
+        if (natives[index]) {
+            for (const auto& native_frame : natives[index]->GetNativeFrames())
+                frames.push_back(native_frame->GetFramePc() & mask);
+        }
+#if defined(__AOSP_PARSER__)
+        if (record->thread) {
+            // native and java parts stay apart.
+            frames.push_back(0x0);
+            art::Thread* thread = reinterpret_cast<art::Thread*>(record->thread);
+            javas[index] = std::make_unique<art::StackVisitor>(thread, art::StackVisitor::StackWalkKind::kSkipInlinedFrames);
+            try {
+                javas[index]->WalkStack();
+                for (const auto& java_frame : javas[index]->GetJavaFrames()) {
+                    frames.push_back(java_frame->GetMethod().Ptr());
+                    frames.push_back(java_frame->GetDexPcPtr());
+                }
+            } catch(InvalidAddressException& e) {}
+        }
+#endif
+
+        std::vector<uint64_t>& bucket = buckets[HashFrames(frames)];
+        StackGroup* group = nullptr;
+        for (uint64_t id : bucket) {
+            if (groups[id].frames == frames) {
+                group = &groups[id];
+                break;
             }
-            LOGI(format.c_str(), frameid, native_frame->GetFramePc(), method_desc.c_str());
-            ++frameid;
-            if (frameid == unwind_stack->GetContextNum()) {
-                LOGI(ANSI_COLOR_LIGHTRED "    <<maybe handle signal ucontext: 0x%" PRIx64 ">>\n" ANSI_COLOR_RESET, unwind_stack->GetContext());
-                unwind_stack->DumpContextRegister("  ");
+        }
+        if (!group) {
+            bucket.push_back(groups.size());
+            groups.push_back({std::move(frames), {}, index});
+            group = &groups.back();
+        }
+        group->tids.push_back(record->pid);
+    }
+
+    std::stable_sort(groups.begin(), groups.end(),
+            [](const StackGroup& a, const StackGroup& b) { return a.tids.size() > b.tids.size(); });
+
+    bool needEnd = false;
+    for (const auto& group : groups) {
+        if (needEnd) ENTER();
+        std::string tids;
+        for (int tid : group.tids) {
+            if (tids.length()) tids.append(" ");
+            tids.append(std::to_string(tid));
+        }
+        LOGI("Threads(" ANSI_COLOR_LIGHTMAGENTA "%zu" ANSI_COLOR_RESET ") " ANSI_COLOR_YELLOW "%s\n" ANSI_COLOR_RESET,
+                group.tids.size(), tids.c_str());
+
+        uint64_t index = group.first;
+        if (natives[index]) {
+            DumpNativeFrames(natives[index].get());
+        } else if (!options.threads[index]->api) {
+            LOGI("  (NOT EXIST THREAD)\n");
+        }
+#if defined(__AOSP_PARSER__)
+        if (javas[index]) {
+            try {
+                DumpJavaFrames(javas[index].get());
+            } catch(InvalidAddressException& e) {
+                LOGI(ANSI_COLOR_RED "  (STACK MAYBE INCOIMPLETE)\n" ANSI_COLOR_RESET);
             }
         }
+#endif
+        needEnd = true;
     }
 }
 
@@ -309,9 +484,10 @@ void BacktraceCommand::DumpJavaJniStack(uint32_t *subjni, ThreadApi* api) {
         std::unique_ptr<arm64::UnwindStack> unwind_stack = std::make_unique<arm64::UnwindStack>(api);
         unwind_stack->OnlyFpBackStack(options.dump_fps[*subjni]);
         std::string sub_format = FormatJNINativeFrame("      ", unwind_stack->GetNativeFrames().size());
+        std::string method_desc;
         uint32_t sub_frameid = 0;
         for (const auto& native_frame : unwind_stack->GetNativeFrames()) {
-            std::string method_desc = native_frame->GetMethodName();
+            method_desc.assign(native_frame->GetMethodName());
             uint64_t offset = (native_frame->GetFramePc() & CoreApi::GetVabitsMask()) - native_frame->GetMethodOffset();
             if (offset && native_frame->GetMethodOffset())
                 method_desc.append("+").append(Utils::ToHex(offset));
@@ -444,6 +620,7 @@ void BacktraceCommand::usage() {
     LOGI("    -a, --all           show thread stack.\n");
     LOGI("    -d, --detail        show more info.\n");
     LOGI("        --fp <FP_REG>   only support arm64\n");
+    LOGI("    -g, --group         group threads with the same stack.\n");
     ENTER();
     LOGI("core-parser> bt\n");
     LOGI("\"main\" sysTid=6118 Runnable\n");
@@ -21,8 +21,17 @@
 #include "api/thread.h"
 #include "command/command.h"
 #include <memory>
+#include <string>
 #include <vector>
 
+namespace api {
+class UnwindStack;
+} // namespace api
+
+namespace art {
+class StackVisitor;
+} // namespace art
+
 class BacktraceCommand : public Command {
 public:
     BacktraceCommand() : Command("backtrace", "bt") {}
@@ -33,6 +42,7 @@ public:
     struct Options : Command::Options {
         bool dump_all;
         bool dump_detail;
+        bool dump_group;
         std::vector<uint64_t> dump_fps;
         std::vector<std::unique_ptr<ThreadRecord>> threads;
     };
@@ -80,9 +90,13 @@ public:
 
     ThreadRecord* findRecord(int pid);
     void DumpTrace();
+    void DumpNativeStacks(std::vector<std::string>& natives);
+    void DumpGroups();
     void DumpJavaStack(void *thread, ThreadApi* api);
     void DumpJavaJniStack(uint32_t *subjni, ThreadApi* api);
     void DumpNativeStack(void *thread, ThreadApi* api);
+    void DumpNativeFrames(api::UnwindStack* unwind_stack);
+    void DumpJavaFrames(art::StackVisitor* visitor);
     static std::string FormatJavaFrame(const char* prefix, uint64_t size);
     static std::string FormatJNINativeFrame(const char* prefix, uint64_t size);
     static std::string FormatNativeFrame(const char* prefix, uint64_t size);
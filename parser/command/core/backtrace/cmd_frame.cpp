@@ -291,10 +291,11 @@ void FrameCommand::ShowNativeFrameInfo(int number) {
     if (unwind_stack) {
         unwind_stack->WalkStack();
         std::string format = BacktraceCommand::FormatNativeFrame("  ", unwind_stack->GetNativeFrames().size());
+        std::string method_desc;
         uint32_t frameid = 0;
         for (const auto& native_frame : unwind_stack->GetNativeFrames()) {
             if (options.dump_all || frameid == number) {
-                std::string method_desc = native_frame->GetMethodName();
+                method_desc.assign(native_frame->GetMethodName());
                 uint64_t cloc_pc = native_frame->GetFramePc() & CoreApi::GetVabitsMask();
                 uint64_t offset = cloc_pc - native_frame->GetMethodOffset();
                 if (offset && native_frame->GetMethodOffset())
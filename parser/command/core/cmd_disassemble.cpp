@@ -16,7 +16,6 @@
 
 #include "logger/log.h"
 #include "base/utils.h"
-#include "llvm/Demangle/Demangle.h"
 #include "command/core/cmd_disassemble.h"
 #include "common/native_frame.h"
 #include "common/disassemble/capstone.h"
@@ -87,16 +86,11 @@ int DisassembleCommand::main(int argc, char* const argv[]) {
         LOGI("LIB: " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET, map->name());
 
         std::string d_symbol;
-        char* demangled_name = llvm::itaniumDemangle(entry.symbol.data());
-        if (!demangled_name)
-            demangled_name = llvm::rustDemangle(entry.symbol.data());
-        if (demangled_name) {
-            LOGI("SYMBOL: " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET, entry.symbol.c_str());
-            d_symbol = demangled_name;
-            std::free(demangled_name);
-        } else {
-            d_symbol = entry.symbol;
-        }
+        std::string_view demangled = CoreApi::Demangle(map, map->l_addr() + entry.offset, entry.symbol.data(), d_symbol);
+        if (demangled.length())
+            d_symbol = demangled;
+        if (d_symbol != entry.symbol)
+            LOGI("SYMBOL: " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET, entry.symbol.data());
 
         bool vdso = !strcmp(map->name(), "[vdso]");
         uint64_t vaddr = map->l_addr() + entry.offset;
@@ -122,7 +122,7 @@ void LinkMapCommand::ShowLinkMapSymbols(LinkMap* map) {
         if (CoreApi::GetMachine() == EM_ARM)
             offset &= (CoreApi::GetPointMask() - 1);
         LOGI(ANSI_COLOR_CYAN "%016l" PRIx64 "" ANSI_COLOR_RESET "  %016l" PRIx64 "  %016l" PRIx64 "  " ANSI_COLOR_YELLOW "%s\n" ANSI_COLOR_RESET,
-                map->l_addr() + offset, entry.size, entry.type, entry.symbol.c_str());
+                map->l_addr() + offset, entry.size, entry.type, entry.symbol.data());
     }
 }
 
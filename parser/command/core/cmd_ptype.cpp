@@ -32,39 +32,34 @@ int PtypeCommand::main(int argc, char* const argv[]) {
 
 int PtypeCommand::DumpStructInfo(PtypeCommand::Options& options, const char* name) {
     std::string target = name;
+    if (target.size() >= 2 && target.front() == '\'' && target.back() == '\'')
+        target = target.substr(1, target.size() - 2);
+
     auto callback = [&](LinkMap* map) -> bool {
         std::unique_ptr<dwarf::DwarfLoader>& loader = map->GetDwarfLoader();
         if (!loader)
             return false;
 
-        loader->ForEachStruct([&](const dwarf::StructInfo& si) {
-            if (target.size() >= 2 && target.front() == '\'' && target.back() == '\'')
-                target = target.substr(1, target.size() - 2);
-
-            if (si.name != target)
-                return false;
+        const dwarf::StructInfo* si = loader->FindStruct(target);
+        if (!si || !si->has_size)
+            return false;
 
-            if (si.has_size) {
-                LOGI("LIB: " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET, map->name());
-                LOGI("[%s]  size=%u\n", si.name.c_str(), si.byte_size);
+        LOGI("LIB: " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET, map->name());
+        LOGI("[%s]  size=%u\n", si->name.c_str(), si->byte_size);
 
-                for (const auto& bi : si.bases) {
-                    if (bi.has_offset)
-                        LOGI("    base: %s @ %u\n", bi.type_name.c_str(), bi.offset);
-                    else
-                        LOGI("    base: %s\n", bi.type_name.c_str());
-                }
-                for (const auto& mi : si.members) {
-                    if (mi.has_offset)
-                        LOGI("    [%u] %s : %s\n", mi.offset, mi.name.c_str(), mi.type_name.c_str());
-                    else
-                        LOGI("    %s : %s\n", mi.name.c_str(), mi.type_name.c_str());
-                }
-                ENTER();
-                return true;
-            }
-            return false;
-        });
+        for (const auto& bi : si->bases) {
+            if (bi.has_offset)
+                LOGI("    base: %s @ %u\n", bi.type_name.c_str(), bi.offset);
+            else
+                LOGI("    base: %s\n", bi.type_name.c_str());
+        }
+        for (const auto& mi : si->members) {
+            if (mi.has_offset)
+                LOGI("    [%u] %s : %s\n", mi.offset, mi.name.c_str(), mi.type_name.c_str());
+            else
+                LOGI("    %s : %s\n", mi.name.c_str(), mi.type_name.c_str());
+        }
+        ENTER();
         return false;
     };
     CoreApi::ForeachLinkMap(callback);
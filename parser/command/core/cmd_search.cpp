@@ -18,11 +18,35 @@
 #include "command/command_manager.h"
 #include "logger/log.h"
 #include "base/utils.h"
+#include "base/macros.h"
+#include "base/thread_pool.h"
 #include "api/core.h"
+#include "api/pointer_index.h"
+#include "common/link_map.h"
 #include <unistd.h>
 #include <getopt.h>
-#include <iostream>
-#include <sstream>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+static bool ParseHexBytes(const char* hex, std::string& bytes) {
+    std::string digits;
+    for (const char* c = hex; *c; ++c) {
+        if (*c == ' ' || *c == ':')
+            continue;
+        if (!isxdigit(static_cast<unsigned char>(*c)))
+            return false;
+        digits.push_back(*c);
+    }
+    if (!digits.length() || (digits.length() & 1))
+        return false;
+
+    for (int i = 0; i < digits.length(); i += 2)
+        bytes.push_back(static_cast<char>(std::stoi(digits.substr(i, 2), nullptr, 16)));
+    return true;
+}
 
 int CoreSearchCommand::prepare(int argc, char* const argv[]) {
     if (!CoreApi::IsReady()
@@ -31,6 +55,15 @@ int CoreSearchCommand::prepare(int argc, char* const argv[]) {
 
     options.flags = 0x0;
     options.in_stack = false;
+    options.build_index = false;
+    options.type = SEARCH_VALUE;
+    options.min = 0x0;
+    options.max = 0x0;
+    options.bytes.clear();
+
+    bool hex = false;
+    bool string = false;
+    const char* end = nullptr;
 
     int opt;
     int option_index = 0;
@@ -40,10 +73,14 @@ int CoreSearchCommand::prepare(int argc, char* const argv[]) {
         {"read",   no_argument,       0,  'r'},
         {"write",  no_argument,       0,  'w'},
         {"exec",   no_argument,       0,  'x'},
+        {"end",    required_argument, 0,  'e'},
+        {"hex",    no_argument,       0,  'b'},
+        {"string", no_argument,       0,   1 },
+        {"index",  no_argument,       0,  'i'},
         {0,        0,                 0,   0 },
     };
 
-    while ((opt = getopt_long(argc, argv, "srwx",
+    while ((opt = getopt_long(argc, argv, "srwxe:bi",
                 long_options, &option_index)) != -1) {
         switch (opt) {
             case 's':
@@ -58,6 +95,18 @@ int CoreSearchCommand::prepare(int argc, char* const argv[]) {
             case 'x':
                 options.flags |= Block::FLAG_X;
                 break;
+            case 'e':
+                end = optarg;
+                break;
+            case 'b':
+                hex = true;
+                break;
+            case 1:
+                string = true;
+                break;
+            case 'i':
+                options.build_index = true;
+                break;
         }
     }
     options.optind = optind;
@@ -68,73 +117,292 @@ int CoreSearchCommand::prepare(int argc, char* const argv[]) {
         options.flags |= Block::FLAG_X;
     }
 
+    if (options.build_index)
+        return Command::ONCHLD;
+
     if (options.optind >= argc) {
         usage();
         return Command::FINISH;
     }
 
+    const char* value = argv[options.optind];
+    if (hex || string) {
+        options.type = SEARCH_BYTES;
+        if (string) {
+            options.bytes = value;
+        } else if (!ParseHexBytes(value, options.bytes)) {
+            LOGE("Invalid hex bytes \"%s\"\n", value);
+            return Command::FINISH;
+        }
+        if (!options.bytes.length())
+            return Command::FINISH;
+    } else {
+        uint64_t mask = CoreApi::GetVabitsMask();
+        options.min = Utils::atol(value) & mask;
+        // END stays exclusive on the command line, 32-bit END 0x100000000
+        // masks to 0 but END - 1 still lands on 0xffffffff.
+        options.max = end ? ((Utils::atol(end) - 1) & mask) : options.min;
+        if (options.max < options.min) {
+            LOGE("Invalid range [%" PRIx64 ", %" PRIx64 "]\n", options.min, options.max);
+            return Command::FINISH;
+        }
+    }
+
     return Command::ONCHLD;
 }
 
 int CoreSearchCommand::main(int argc, char* const argv[]) {
+    if (options.build_index) {
+        std::string path = PointerIndex::GetPath();
+        if (PointerIndex::Build(path.c_str())) {
+            PointerIndex* index = PointerIndex::Open(path.c_str());
+            LOGI("Index %" PRIu64 " pointers to %s\n", index ? index->size() : 0, path.c_str());
+        }
+        return 0;
+    }
+
     if (options.in_stack)
-        CoreSearchCommand::WalkStack(argv[options.optind]);
+        WalkStack();
     else
-        CoreSearchCommand::WalkLoadBlock(argv[options.optind], options.flags);
+        WalkLoadBlock();
     return 0;
 }
 
-void CoreSearchCommand::WalkStack(const char* value) {
+void CoreSearchCommand::WalkStack() {
     auto callback = [&](ThreadApi *api) -> bool {
         LOGI("Thread(\"" ANSI_COLOR_YELLOW "%d" ANSI_COLOR_RESET "\")\n", api->pid());
         LoadBlock *block = CoreApi::FindLoadBlock(api->GetFrameSP(), false);
         if (block && block->isValid()) {
-            int argc = 7;
-            std::string bs = Utils::ToHex(block->vaddr());
-            std::string es = Utils::ToHex(block->vaddr() + block->memsz());
-
-            char* argv[8] = {
-                const_cast<char*>("rd"),
-                const_cast<char*>(bs.c_str()),
-                const_cast<char*>("-e"),
-                const_cast<char*>(es.c_str()),
-                const_cast<char*>("|"),
-                const_cast<char*>("grep"),
-                const_cast<char*>(value),
-                nullptr};
-            CommandManager::Execute(argv[0], argc, argv);
+            std::vector<LoadBlock*> blocks = { block };
+            std::vector<Match> matches;
+            Search(blocks, matches);
+            for (auto& match : matches)
+                ShowMatch(match);
         }
         return false;
     };
     CoreApi::ForeachThread(callback);
 }
 
-void CoreSearchCommand::WalkLoadBlock(const char* value, int flags) {
+void CoreSearchCommand::WalkLoadBlock() {
+    std::vector<LoadBlock*> blocks;
     auto callback = [&](LoadBlock *block) -> bool {
-        if (!(flags & block->flags()))
+        if (!(options.flags & block->flags()))
             return false;
 
-        if (block->isValid()) {
-            int argc = 7;
-            std::string bs = Utils::ToHex(block->vaddr());
-            std::string es = Utils::ToHex(block->vaddr() + block->memsz());
-
-            char* argv[8] = {
-                const_cast<char*>("rd"),
-                const_cast<char*>(bs.c_str()),
-                const_cast<char*>("-e"),
-                const_cast<char*>(es.c_str()),
-                const_cast<char*>("|"),
-                const_cast<char*>("grep"),
-                const_cast<char*>(value),
-                nullptr};
-            CommandManager::Execute(argv[0], argc, argv);
-        }
+        if (block->isValid())
+            blocks.push_back(block);
         return false;
     };
     CoreApi::ForeachLoadBlock(callback, false, false);
+
+    std::vector<Match> matches;
+    Search(blocks, matches);
+    for (auto& match : matches)
+        ShowMatch(match);
+}
+
+/*
+ *  block[0]  block[1]           block[2]
+ * |--------|------|------|----|---------|
+ *   task 0  task 1 task 2 ...   task n      --> ThreadPool
+ *
+ * Every task scans one chunk of one block, matches stay in task order
+ * so the output reads like a linear walk of the address space.
+ */
+void CoreSearchCommand::Search(std::vector<LoadBlock*>& blocks, std::vector<Match>& matches) {
+    if (options.type == SEARCH_VALUE && SearchIndex(blocks, matches))
+        return;
+
+    struct Chunk {
+        LoadBlock* block;
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<Chunk> chunks;
+    for (const auto& block : blocks) {
+        uint64_t size = block->size();
+        for (uint64_t offset = 0; offset < size; offset += kChunkSize)
+            chunks.push_back({block, offset, std::min(kChunkSize, size - offset)});
+    }
+
+    std::vector<std::vector<Match>> results(chunks.size());
+    ThreadPool::ParallelFor(chunks.size(), [&](uint64_t index, int worker) {
+        Chunk& chunk = chunks[index];
+        if (options.type == SEARCH_VALUE) {
+            ScanValues(chunk.block, chunk.offset, chunk.size, results[index]);
+        } else {
+            ScanBytes(chunk.block, chunk.offset, chunk.size, results[index]);
+        }
+    });
+
+    for (const auto& result : results)
+        matches.insert(matches.end(), result.begin(), result.end());
+}
+
+/*
+ * Answer from the "cs --index" file when [min, max] lies inside one valid
+ * block, the index holds nothing else. Every hit is re-read from the core
+ * so it never reports a different word than the full scan.
+ */
+bool CoreSearchCommand::SearchIndex(std::vector<LoadBlock*>& blocks, std::vector<Match>& matches) {
+    LoadBlock* target = CoreApi::FindLoadBlock(options.min, false);
+    if (!target || !target->isValid()
+            || options.max >= target->vaddr() + target->memsz())
+        return false;
+
+    PointerIndex* index = PointerIndex::Open(PointerIndex::GetPath().c_str());
+    if (!index)
+        return false;
+
+    std::vector<LoadBlock*> sorted = blocks;
+    std::sort(sorted.begin(), sorted.end());
+    int point_size = CoreApi::GetPointSize();
+    uint64_t mask = CoreApi::GetVabitsMask();
+    auto callback = [&](uint64_t value, uint64_t source) -> bool {
+        LoadBlock* block = CoreApi::FindLoadBlock(source, false);
+        if (!block || !std::binary_search(sorted.begin(), sorted.end(), block))
+            return false;
+
+        uint64_t word = 0x0;
+        memcpy(&word, reinterpret_cast<const uint8_t*>(block->begin()) + (source - block->vaddr()), point_size);
+        if ((word & mask) - options.min <= options.max - options.min)
+            matches.push_back({source, word, block});
+        return false;
+    };
+    index->Find(options.min, options.max + 1, callback);
+
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) { return a.addr < b.addr; });
+    matches.erase(std::unique(matches.begin(), matches.end(),
+            [](const Match& a, const Match& b) { return a.addr == b.addr; }), matches.end());
+    return true;
+}
+
+/*
+ * (value - min) <= (max - min) tests the range with one unsigned compare,
+ * four values are or-ed before branching so the loop stays branch free
+ * and the compiler can keep it in vector registers.
+ */
+template <typename T>
+static void ScanAlignedValues(const uint8_t* data, uint64_t count, uint64_t vaddr,
+                              uint64_t mask, uint64_t min, uint64_t span,
+                              std::function<void (uint64_t addr, uint64_t value)> fn) {
+    const T tmask = static_cast<T>(mask);
+    const T tmin = static_cast<T>(min);
+    // span is max - min, inclusive, so a 32-bit range can end at 0xffffffff.
+    const T tspan = static_cast<T>(std::min<uint64_t>(span, std::numeric_limits<T>::max()));
+    uint64_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        T v[4];
+        memcpy(v, data + i * sizeof(T), sizeof(v));
+        bool hit = ((T)((v[0] & tmask) - tmin) <= tspan)
+                 | ((T)((v[1] & tmask) - tmin) <= tspan)
+                 | ((T)((v[2] & tmask) - tmin) <= tspan)
+                 | ((T)((v[3] & tmask) - tmin) <= tspan);
+        if (LIKELY(!hit))
+            continue;
+
+        for (int k = 0; k < 4; ++k) {
+            if ((T)((v[k] & tmask) - tmin) <= tspan)
+                fn(vaddr + (i + k) * sizeof(T), v[k]);
+        }
+    }
+    for (; i < count; ++i) {
+        T value;
+        memcpy(&value, data + i * sizeof(T), sizeof(value));
+        if ((T)((value & tmask) - tmin) <= tspan)
+            fn(vaddr + i * sizeof(T), value);
+    }
+}
+
+void CoreSearchCommand::ScanValues(LoadBlock* block, uint64_t offset, uint64_t size, std::vector<Match>& matches) {
+    int point_size = CoreApi::GetPointSize();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(block->begin()) + offset;
+    uint64_t vaddr = block->vaddr() + offset;
+    uint64_t count = size / point_size;
+    uint64_t span = options.max - options.min;
+
+    auto callback = [&](uint64_t addr, uint64_t value) {
+        matches.push_back({addr, value, block});
+    };
+
+    if (point_size == 8) {
+        ScanAlignedValues<uint64_t>(data, count, vaddr, CoreApi::GetVabitsMask(), options.min, span, callback);
+    } else {
+        ScanAlignedValues<uint32_t>(data, count, vaddr, CoreApi::GetVabitsMask(), options.min, span, callback);
+    }
+}
+
+void CoreSearchCommand::ScanBytes(LoadBlock* block, uint64_t offset, uint64_t size, std::vector<Match>& matches) {
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(block->begin());
+    const uint8_t* pattern = reinterpret_cast<const uint8_t*>(options.bytes.data());
+    uint64_t length = options.bytes.length();
+
+    // a match may start in this chunk and end in the next one.
+    uint64_t limit = std::min(offset + size + length - 1, block->size());
+    const uint8_t* cur = begin + offset;
+    const uint8_t* end = begin + limit;
+    const uint8_t* last = begin + offset + size;
+    while (cur < last && static_cast<uint64_t>(end - cur) >= length) {
+        // memchr is vectorized by libc, skip to the first byte then compare.
+        const uint8_t* hit = reinterpret_cast<const uint8_t*>(memchr(cur, pattern[0], last - cur));
+        if (!hit || static_cast<uint64_t>(end - hit) < length)
+            break;
+
+        if (!memcmp(hit, pattern, length)) {
+            uint64_t addr = block->vaddr() + (hit - begin);
+            uint64_t value = 0x0;
+            memcpy(&value, hit, std::min(length, static_cast<uint64_t>(sizeof(value))));
+            matches.push_back({addr, value, block});
+        }
+        cur = hit + 1;
+    }
+}
+
+void CoreSearchCommand::ShowMatch(Match& match) {
+    std::string where;
+    LinkMap* handle = match.block->handle();
+    if (handle) {
+        where.append(handle->name());
+        SymbolEntry entry = handle->DlRegionSymEntry(match.addr);
+        if (entry.IsValid()) {
+            uint64_t symaddr = entry.offset + handle->l_addr();
+            where.append(" (");
+            where.append(entry.symbol.data());
+            where.append("+");
+            where.append(Utils::ToHex(match.addr - symaddr));
+            where.append(")");
+        }
+    } else if (match.block->name().length()) {
+        where.append(match.block->name());
+    } else {
+        where.append("[]");
+    }
+
+    if (CoreApi::GetPointSize() == 8) {
+        LOGI(ANSI_COLOR_CYAN "%" PRIx64 "" ANSI_COLOR_RESET ": %016" PRIx64 "  %s  " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET,
+                match.addr, match.value, Utils::ConvertAscii(match.value, 8).c_str(), where.c_str());
+    } else {
+        LOGI(ANSI_COLOR_CYAN "%" PRIx64 "" ANSI_COLOR_RESET ": %08" PRIx64 "  %s  " ANSI_COLOR_GREEN "%s\n" ANSI_COLOR_RESET,
+                match.addr, match.value & 0xFFFFFFFF, Utils::ConvertAscii(match.value, 4).c_str(), where.c_str());
+    }
 }
 
 void CoreSearchCommand::usage() {
-    LOGI("Usage: cs <ADDR> [OPTION]\n");
+    LOGI("Usage: cs <VALUE> [OPTION]\n");
+    LOGI("       cs --index\n");
+    LOGI("Option:\n");
+    LOGI("    -s, --stack            only search thread stacks\n");
+    LOGI("    -r, --read             search readable blocks\n");
+    LOGI("    -w, --write            search writable blocks\n");
+    LOGI("    -x, --exec             search executable blocks\n");
+    LOGI("    -e, --end <END>        search pointer values in [VALUE, END)\n");
+    LOGI("    -b, --hex              VALUE is a byte pattern, e.g. \"de ad be ef\"\n");
+    LOGI("        --string           VALUE is an ascii string\n");
+    LOGI("    -i, --index            build reverse pointer index <core>.ptridx, pointer\n");
+    LOGI("                           searches then read it instead of scanning memory\n");
+    ENTER();
+    LOGI("core-parser> cs 0x12c4d6b0\n");
+    LOGI("7fff3cf8a3e8: 0000000012c4d6b0  ........  [stack]\n");
+    LOGI("7fde0a5b1e28: 0000000012c4d6b0  ........  /system/lib64/libart.so (_ZN3art7Runtime9instance_E+0x0)\n");
 }
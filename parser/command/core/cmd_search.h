@@ -18,22 +18,46 @@
 #define PARSER_COMMAND_CORE_CMD_CS_H_
 
 #include "command/command.h"
+#include "common/load_block.h"
+#include <string>
+#include <vector>
 
 class CoreSearchCommand : public Command {
 public:
+    static constexpr int SEARCH_VALUE = 0;
+    static constexpr int SEARCH_BYTES = 1;
+    // large blocks are split, so one heap block doesn't keep a single worker busy.
+    static constexpr uint64_t kChunkSize = 16 * 1024 * 1024;
+
     CoreSearchCommand() : Command("cs") {}
     ~CoreSearchCommand() {}
 
     struct Options : Command::Options {
         int flags;
         bool in_stack;
+        bool build_index;
+        int type;
+        uint64_t min;
+        uint64_t max;   // [min, max], inclusive so the top of the address space is reachable
+        std::string bytes;
+    };
+
+    struct Match {
+        uint64_t addr;
+        uint64_t value;
+        LoadBlock* block;
     };
 
     int main(int argc, char* const argv[]);
     int prepare(int argc, char* const argv[]);
     void usage();
-    static void WalkStack(const char* value);
-    static void WalkLoadBlock(const char* value, int flags);
+    void WalkStack();
+    void WalkLoadBlock();
+    void Search(std::vector<LoadBlock*>& blocks, std::vector<Match>& matches);
+    bool SearchIndex(std::vector<LoadBlock*>& blocks, std::vector<Match>& matches);
+    void ScanValues(LoadBlock* block, uint64_t offset, uint64_t size, std::vector<Match>& matches);
+    void ScanBytes(LoadBlock* block, uint64_t offset, uint64_t size, std::vector<Match>& matches);
+    void ShowMatch(Match& match);
 private:
     Options options;
 };
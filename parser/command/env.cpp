@@ -19,6 +19,7 @@
 #include "api/core.h"
 #include "android.h"
 #include "llvm.h"
+#include "base/shared_cache.h"
 
 std::unique_ptr<Env> Env::INSTANCE = nullptr;
 
@@ -65,4 +66,5 @@ void Env::Init() {
 
 void Env::Dump() {
     LOGI("  * Thread: " ANSI_COLOR_LIGHTMAGENTA "%d\n" ANSI_COLOR_RESET, CurrentPid());
+    SharedCache::Dump();
 }
@@ -16,6 +16,7 @@
 
 #include "command/command.h"
 #include "common/exception.h"
+#include "base/shared_cache.h"
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -23,6 +24,7 @@
 #include <string.h>
 
 int Command::execute(int argc, char* const argv[]) {
+    SharedCache::Init();
     int state = prepare(argc, argv);
     if (state == ONCHLD) {
         pid_t pid = fork();
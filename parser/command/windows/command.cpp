@@ -16,10 +16,12 @@
 
 #include "command/command.h"
 #include "common/exception.h"
+#include "base/shared_cache.h"
 #include <string.h>
 #include <signal.h>
 
 int Command::execute(int argc, char* const argv[]) {
+    SharedCache::Init();
     int state = prepare(argc, argv);
     if (state == ONCHLD || state == CONTINUE) {
         try {
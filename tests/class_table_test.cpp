@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "command/android/cmd_top.h"
+#include "test_helper.h"
+#include <stdint.h>
+#include <map>
+#include <random>
+
+int main(int argc, const char* argv[]) {
+    // several workers' tables merged into one must match a plain map,
+    // enough keys to force every table through a few Grow() rounds.
+    std::mt19937 random(0x5eed);
+    std::map<uint32_t, TopCommand::Pair> expect;
+    TopCommand::ClassTable tables[3];
+    for (int i = 0; i < 300000; ++i) {
+        uint32_t klass = (random() % 50000) * 8 + 8;
+        uint64_t size = random() % 256;
+        TopCommand::ClassTable::Entry& entry = tables[i % 3].Get(klass);
+        Expect(entry.klass == klass, "get");
+        entry.pair.alloc_count++;
+        entry.pair.shallow_size += size;
+        TopCommand::Pair& pair = expect[klass];
+        pair.alloc_count++;
+        pair.shallow_size += size;
+    }
+
+    // an empty table merges both ways
+    TopCommand::ClassTable empty;
+    tables[1].Merge(empty);
+    empty.Merge(tables[0]);
+    Expect(empty.size() == tables[0].size(), "merge into empty");
+
+    tables[0].Merge(tables[1]);
+    tables[0].Merge(tables[2]);
+    Expect(tables[0].size() == expect.size(), "size");
+
+    uint64_t seen = 0;
+    for (const auto& entry : tables[0].GetSlots()) {
+        if (!entry.klass)
+            continue;
+        seen++;
+        auto it = expect.find(entry.klass);
+        if (it == expect.end()) {
+            Expect(false, "unknown class");
+            continue;
+        }
+        Expect(entry.pair.alloc_count == it->second.alloc_count
+                && entry.pair.shallow_size == it->second.shallow_size, "pair");
+    }
+    Expect(seen == expect.size(), "slots");
+
+    return TestResult("class_table_test");
+}
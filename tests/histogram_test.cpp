@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "command/android/cmd_histogram.h"
+#include "test_helper.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+static bool Equals(HistogramCommand::Snapshot& a, HistogramCommand::Snapshot& b) {
+    if (a.size() != b.size())
+        return false;
+    for (auto ait = a.begin(), bit = b.begin(); ait != a.end(); ++ait, ++bit) {
+        if (ait->first != bit->first
+                || ait->second.alloc_count != bit->second.alloc_count
+                || ait->second.shallow_size != bit->second.shallow_size
+                || ait->second.native_size != bit->second.native_size)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, const char* argv[]) {
+    std::string prefix = "histogram_test." + std::to_string(getpid());
+    std::string binary = prefix + ".histo";
+    std::string csv = prefix + ".csv";
+    std::string after = prefix + ".after.histo";
+
+    HistogramCommand::Snapshot snapshot;
+    snapshot["byte[]"] = {10, 1024, 0, 0};
+    snapshot["java.lang.String"] = {200, 4800, 0, 0};
+    snapshot["android.graphics.Bitmap"] = {2, 128, 81920, 0};
+    snapshot["com.example.Outer$Inner, with comma"] = {1, 16, 0, 0};
+
+    // round trip, both formats
+    Expect(HistogramCommand::Save(snapshot, binary.c_str(), false), "save binary");
+    Expect(HistogramCommand::Save(snapshot, csv.c_str(), true), "save csv");
+    HistogramCommand::Snapshot loaded;
+    Expect(HistogramCommand::Load(loaded, binary.c_str()) && Equals(loaded, snapshot), "load binary");
+    loaded.clear();
+    Expect(HistogramCommand::Load(loaded, csv.c_str()) && Equals(loaded, snapshot), "load csv");
+
+    // duplicate names sum in both formats
+    HistogramCommand::Snapshot doubled = snapshot;
+    for (auto& value : doubled) {
+        value.second.alloc_count *= 2;
+        value.second.shallow_size *= 2;
+        value.second.native_size *= 2;
+    }
+    std::string data = ReadAll(binary);
+    std::string records = data.substr(2 * sizeof(uint64_t));
+    uint64_t count = snapshot.size() * 2;
+    std::string dup = data.substr(0, sizeof(uint64_t));
+    dup.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    dup.append(records).append(records);
+    WriteAll(binary, dup);
+    loaded.clear();
+    Expect(HistogramCommand::Load(loaded, binary.c_str()) && Equals(loaded, doubled), "binary duplicates");
+
+    WriteAll(csv, "count,shallow,native,name\n1,2,3,a\n4,5,6,a\n");
+    loaded.clear();
+    Expect(HistogramCommand::Load(loaded, csv.c_str()) && loaded.size() == 1
+            && loaded["a"].alloc_count == 5 && loaded["a"].shallow_size == 7
+            && loaded["a"].native_size == 9, "csv duplicates");
+
+    // corrupt input
+    WriteAll(binary, dup.substr(0, dup.size() - 1));
+    Expect(!HistogramCommand::Load(loaded, binary.c_str()), "truncated");
+    WriteAll(csv, "count,shallow,native,name\nbad\n");
+    Expect(!HistogramCommand::Load(loaded, csv.c_str()), "bad line");
+    WriteAll(csv, "not a snapshot\n");
+    Expect(!HistogramCommand::Load(loaded, csv.c_str()), "bad header");
+
+    // diff drives Load on both sides and prints the deltas
+    Expect(HistogramCommand::Save(snapshot, binary.c_str(), false), "save before");
+    Expect(HistogramCommand::Save(doubled, after.c_str(), false), "save after");
+    std::vector<std::string> args = {"diff", "-a", binary, after, "2"};
+    std::vector<char*> argv2;
+    for (auto& arg : args) argv2.push_back(&arg[0]);
+    argv2.push_back(nullptr);
+    Expect(HistogramCommand::Diff(args.size(), argv2.data()) == 0, "diff");
+
+    remove(binary.c_str());
+    remove(csv.c_str());
+    remove(after.c_str());
+    return TestResult("histogram_test");
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "api/symbol_cache.h"
+#include "common/symbol_table.h"
+#include "api/dwarf.h"
+#include "test_helper.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+struct SymbolCacheProbe {
+    uint32_t id;
+    SymbolCacheProbe* next;
+};
+
+int main(int argc, const char* argv[]) {
+    SymbolCacheProbe probe = {0, nullptr};
+    Expect(!probe.next, "probe");
+
+    std::string path = "symbol_cache_test." + std::to_string(getpid()) + ".symcache";
+    uint64_t mask = -1;
+
+    SymbolTable table;
+    std::vector<std::string> names;
+    uint64_t offset = 0x1000;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("_ZN3art6Method" + std::to_string(i) + "Ev");
+        table.Insert(SymbolEntry(offset, 0x12 /* STT_FUNC */, 0x40, names.back().c_str()));
+        offset += 0x50;
+    }
+    table.Build(mask);
+    std::string dwarf("opaque dwarf index\0bytes", 25);
+    Expect(SymbolCache::Write(path.c_str(), mask, table, dwarf), "write");
+
+    // round trip
+    SymbolTable loaded;
+    std::string dwarf_loaded;
+    Expect(SymbolCache::Read(path.c_str(), mask, loaded, dwarf_loaded), "read");
+    Expect(dwarf_loaded == dwarf, "dwarf");
+    Expect(loaded.size() == table.size(), "size");
+    for (int i = 0; i < names.size(); ++i) {
+        SymbolEntry entry = loaded.Find(names[i].c_str());
+        Expect(entry.IsValid() && entry.offset == 0x1000 + i * 0x50, "find");
+        entry = loaded.FindRegion(0x1000 + i * 0x50 + 0x20);
+        Expect(entry.IsValid() && entry.symbol == names[i], "region");
+    }
+    Expect(!loaded.FindRegion(0x1000 + 0x48).IsValid(), "gap");
+
+    SymbolTable other;
+    Expect(!SymbolCache::Read(path.c_str(), 0xfffffffe, other, dwarf_loaded), "mask mismatch");
+
+    std::string good = ReadAll(path);
+    uint64_t header = sizeof(SymbolCache::Header);
+    uint64_t records = table.size() * sizeof(SymbolTable::Record);
+    uint64_t names_size = reinterpret_cast<const SymbolCache::Header*>(good.data())->names_size;
+
+    // truncated
+    for (uint64_t size : {header - 1, header + records / 2, header + records + names_size, good.size() - 1}) {
+        std::string bad = good.substr(0, size);
+        WriteAll(path, bad);
+        SymbolTable symbols;
+        Expect(!SymbolCache::Read(path.c_str(), mask, symbols, dwarf_loaded) && symbols.empty(), "truncated");
+    }
+
+    // record name outside the names
+    {
+        std::string bad = good;
+        SymbolTable::Record* record = reinterpret_cast<SymbolTable::Record*>(&bad[header]);
+        record[table.size() - 1].name = names_size;
+        WriteAll(path, bad);
+        SymbolTable symbols;
+        Expect(!SymbolCache::Read(path.c_str(), mask, symbols, dwarf_loaded), "name out of range");
+    }
+
+    // last name not terminated
+    {
+        std::string bad = good;
+        bad[header + records + names_size - 1] = 'x';
+        WriteAll(path, bad);
+        SymbolTable symbols;
+        Expect(!SymbolCache::Read(path.c_str(), mask, symbols, dwarf_loaded), "unterminated name");
+    }
+
+    // records count beyond the file
+    {
+        std::string bad = good;
+        reinterpret_cast<SymbolCache::Header*>(&bad[0])->records = -1;
+        WriteAll(path, bad);
+        SymbolTable symbols;
+        Expect(!SymbolCache::Read(path.c_str(), mask, symbols, dwarf_loaded), "records overflow");
+    }
+
+    remove(path.c_str());
+
+    // the dwarf index of this very binary, which is built with -g.
+    std::unique_ptr<dwarf::DwarfLoader> scanned = dwarf::DwarfLoader::Load("/proc/self/exe");
+    Expect(scanned != nullptr, "dwarf scan");
+    if (scanned) {
+        std::string index;
+        scanned->WriteIndex(index);
+        // rename the probe in the index only, just a loader that took the
+        // index knows the new name.
+        uint64_t pos = index.find("SymbolCacheProbe");
+        Expect(pos != std::string::npos, "dwarf index name");
+        if (pos != std::string::npos)
+            index.replace(pos, 16, "SymbolCacheProbX");
+        std::unique_ptr<dwarf::DwarfLoader> cached = dwarf::DwarfLoader::Load("/proc/self/exe", index);
+        Expect(cached != nullptr, "dwarf cached");
+        if (cached) {
+            std::string again;
+            cached->WriteIndex(again);
+            Expect(again.size() == index.size(), "dwarf index size");
+            Expect(!cached->FindStruct("SymbolCacheProbe"), "dwarf not scanned");
+            const dwarf::StructInfo* si = cached->FindStruct("SymbolCacheProbX");
+            Expect(si && si->has_size && si->byte_size == sizeof(SymbolCacheProbe)
+                    && si->members.size() == 2 && si->members[1].name == "next"
+                    && si->members[1].offset == offsetof(SymbolCacheProbe, next), "dwarf struct");
+        }
+
+        // a damaged index is ignored, the file is scanned again.
+        std::string bad = index.substr(0, index.size() - 1);
+        std::unique_ptr<dwarf::DwarfLoader> rescanned = dwarf::DwarfLoader::Load("/proc/self/exe", bad);
+        Expect(rescanned && rescanned->FindStruct("SymbolCacheProbe"), "dwarf bad index");
+    }
+
+    return TestResult("symbol_cache_test");
+}
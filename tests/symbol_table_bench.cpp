@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/symbol_table.h"
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unordered_set>
+#include <iostream>
+
+using namespace std::chrono;
+
+int main(int argc, const char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 300000;
+    int lookups = argc > 2 ? atoi(argv[2]) : 200;
+
+    std::mt19937_64 random(38);
+    std::unordered_set<SymbolEntry, SymbolEntry::Hash> symbols;
+    // entries only view their names
+    std::vector<std::string> storage(count);
+    SymbolTable table;
+    uint64_t offset = 0x1000;
+    for (int i = 0; i < count; ++i) {
+        uint64_t size = 0x10 + (random() % 0x400);
+        storage[i] = "_ZN3art6Method" + std::to_string(i) + "Ev";
+        SymbolEntry entry(offset, 0x12 /* STT_FUNC */, size, storage[i].c_str());
+        symbols.insert(entry);
+        table.Insert(entry);
+        offset += size + (random() % 0x20);
+    }
+
+    std::vector<uint64_t> pcs(lookups);
+    std::vector<std::string> names(lookups);
+    for (int i = 0; i < lookups; ++i) {
+        pcs[i] = 0x1000 + random() % (offset - 0x1000);
+        names[i] = "_ZN3art6Method" + std::to_string(random() % count) + "Ev";
+    }
+
+    auto starttime = steady_clock::now();
+    table.Build(-1);
+    duration<double> build = steady_clock::now() - starttime;
+
+    uint64_t linear_hits = 0;
+    starttime = steady_clock::now();
+    for (uint64_t pc : pcs) {
+        const auto& it = std::find_if(symbols.begin(), symbols.end(),
+                [&](const SymbolEntry& entry) {
+                    return entry.offset <= pc && pc < entry.offset + entry.size;
+                });
+        if (it != symbols.end()) linear_hits++;
+    }
+    duration<double> linear_region = steady_clock::now() - starttime;
+
+    starttime = steady_clock::now();
+    for (const std::string& name : names) {
+        const auto& it = std::find_if(symbols.begin(), symbols.end(),
+                [&](const SymbolEntry& entry) {
+                    return entry.symbol == name;
+                });
+        if (it != symbols.end()) linear_hits++;
+    }
+    duration<double> linear_name = steady_clock::now() - starttime;
+
+    uint64_t index_hits = 0;
+    starttime = steady_clock::now();
+    for (uint64_t pc : pcs) {
+        if (table.FindRegion(pc).IsValid()) index_hits++;
+    }
+    duration<double> index_region = steady_clock::now() - starttime;
+
+    starttime = steady_clock::now();
+    for (const std::string& name : names) {
+        if (table.Find(name.c_str()).IsValid()) index_hits++;
+    }
+    duration<double> index_name = steady_clock::now() - starttime;
+
+    std::cout << "symbols: " << count << ", lookups: " << lookups << std::endl;
+    std::cout << "build: " << build.count() << " (seconds)" << std::endl;
+    std::cout << "region linear: " << linear_region.count()
+              << " index: " << index_region.count() << " (seconds)" << std::endl;
+    std::cout << "name   linear: " << linear_name.count()
+              << " index: " << index_name.count() << " (seconds)" << std::endl;
+    if (linear_hits != index_hits) {
+        std::cout << "mismatch hits " << linear_hits << " != " << index_hits << std::endl;
+        return 1;
+    }
+    return 0;
+}
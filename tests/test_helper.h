@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TESTS_TEST_HELPER_H_
+#define TESTS_TEST_HELPER_H_
+
+#include <stdio.h>
+#include <string>
+#include <iostream>
+
+/*
+ * Shared by the standalone tests under tests/, each one counts failed
+ * expectations and main returns non-zero when there was any.
+ */
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline void Expect(bool value, const char* what) {
+    if (!value) {
+        std::cout << "FAIL " << what << std::endl;
+        TestFailures()++;
+    }
+}
+
+// prints "<name> ok" or "<name> failed", the exit code of main.
+inline int TestResult(const char* name) {
+    std::cout << name << (TestFailures() ? " failed" : " ok") << std::endl;
+    return TestFailures() ? 1 : 0;
+}
+
+inline std::string ReadAll(const std::string& path) {
+    std::string data;
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return data;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        data.append(buf, n);
+    fclose(fp);
+    return data;
+}
+
+inline void WriteAll(const std::string& path, const std::string& data) {
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) return;
+    fwrite(data.data(), data.size(), 1, fp);
+    fclose(fp);
+}
+
+#endif // TESTS_TEST_HELPER_H_
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/crc32.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_ENGINE_CLMUL
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define CRC32_ENGINE_ARMV8
+#endif
+
+struct Crc32Tables {
+    uint32_t table[8][256];
+
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i << 24;
+            for (int k = 0; k < 8; ++k)
+                crc = (crc & 0x80000000) ? ((crc << 1) ^ Crc32::kPoly) : (crc << 1);
+            table[0][i] = crc;
+        }
+        for (int s = 1; s < 8; ++s) {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t prev = table[s - 1][i];
+                table[s][i] = (prev << 8) ^ table[0][prev >> 24];
+            }
+        }
+    }
+};
+
+static const Crc32Tables& GetTables() {
+    static Crc32Tables tables;
+    return tables;
+}
+
+uint32_t Crc32::UpdateBitwise(uint32_t crc, const uint8_t* data, uint64_t len) {
+    for (uint64_t k = 0; k < len; ++k) {
+        crc ^= (uint32_t)data[k] << 24;
+        for (int i = 0; i < 8; ++i) {
+            if (crc & (1U << 31)) {
+                crc = (crc << 1) ^ kPoly;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+uint32_t Crc32::UpdateSlicing8(uint32_t crc, const uint8_t* data, uint64_t len) {
+    const uint32_t (*t)[256] = GetTables().table;
+
+    while (len >= 8) {
+        uint32_t hi = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16)
+                    | ((uint32_t)data[2] << 8) | data[3];
+        crc ^= hi;
+        crc = t[7][crc >> 24] ^ t[6][(crc >> 16) & 0xFF]
+            ^ t[5][(crc >> 8) & 0xFF] ^ t[4][crc & 0xFF]
+            ^ t[3][data[4]] ^ t[2][data[5]]
+            ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+
+    while (len--) {
+        crc = (crc << 8) ^ t[0][(crc >> 24) ^ *data++];
+    }
+    return crc;
+}
+
+#if defined(CRC32_ENGINE_CLMUL)
+/*
+ * x^n mod P, the data is folded forward by n bits with
+ *   X * x^n == X.hi * (x^(n+64) mod P) + X.lo * (x^n mod P)
+ */
+static uint64_t XPowMod(uint32_t n) {
+    uint32_t r = 1;
+    for (uint32_t i = 0; i < n; ++i)
+        r = (r & 0x80000000) ? ((r << 1) ^ Crc32::kPoly) : (r << 1);
+    return r;
+}
+
+struct ClmulConstants {
+    uint64_t k128[2];
+    uint64_t k256[2];
+    uint64_t k384[2];
+    uint64_t k512[2];
+
+    ClmulConstants() {
+        k128[0] = XPowMod(128); k128[1] = XPowMod(128 + 64);
+        k256[0] = XPowMod(256); k256[1] = XPowMod(256 + 64);
+        k384[0] = XPowMod(384); k384[1] = XPowMod(384 + 64);
+        k512[0] = XPowMod(512); k512[1] = XPowMod(512 + 64);
+    }
+};
+
+static const ClmulConstants& GetClmulConstants() {
+    static ClmulConstants constants;
+    return constants;
+}
+
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i ClmulFold(__m128i x, __m128i k) {
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11),
+                         _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+__attribute__((target("pclmul,ssse3")))
+static uint32_t UpdateClmul(uint32_t crc, const uint8_t* data, uint64_t len) {
+    if (len < 128)
+        return Crc32::UpdateSlicing8(crc, data, len);
+
+    const ClmulConstants& c = GetClmulConstants();
+    // first byte is the highest polynomial term.
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.k128));
+    const __m128i k256 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.k256));
+    const __m128i k384 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.k384));
+    const __m128i k512 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.k512));
+    const __m128i* p = reinterpret_cast<const __m128i*>(data);
+
+    __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128(p + 0), bswap);
+    __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), bswap);
+    __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), bswap);
+    __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), bswap);
+    // init crc equals xor into the first 32 bits.
+    x0 = _mm_xor_si128(x0, _mm_set_epi32(static_cast<int>(crc), 0, 0, 0));
+    p += 4;
+    len -= 64;
+
+    while (len >= 64) {
+        x0 = _mm_xor_si128(ClmulFold(x0, k512), _mm_shuffle_epi8(_mm_loadu_si128(p + 0), bswap));
+        x1 = _mm_xor_si128(ClmulFold(x1, k512), _mm_shuffle_epi8(_mm_loadu_si128(p + 1), bswap));
+        x2 = _mm_xor_si128(ClmulFold(x2, k512), _mm_shuffle_epi8(_mm_loadu_si128(p + 2), bswap));
+        x3 = _mm_xor_si128(ClmulFold(x3, k512), _mm_shuffle_epi8(_mm_loadu_si128(p + 3), bswap));
+        p += 4;
+        len -= 64;
+    }
+
+    __m128i x = _mm_xor_si128(_mm_xor_si128(ClmulFold(x0, k384), ClmulFold(x1, k256)),
+                              _mm_xor_si128(ClmulFold(x2, k128), x3));
+    while (len >= 16) {
+        x = _mm_xor_si128(ClmulFold(x, k128), _mm_shuffle_epi8(_mm_loadu_si128(p), bswap));
+        p += 1;
+        len -= 16;
+    }
+
+    // remainder still needs * x^32 mod P, same as crc of its 16 bytes from 0.
+    uint8_t remainder[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(remainder), _mm_shuffle_epi8(x, bswap));
+    crc = Crc32::UpdateSlicing8(0, remainder, sizeof(remainder));
+    return Crc32::UpdateSlicing8(crc, reinterpret_cast<const uint8_t*>(p), len);
+}
+
+static bool HasHardware() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+#endif // CRC32_ENGINE_CLMUL
+
+#if defined(CRC32_ENGINE_ARMV8)
+/*
+ * crc32 instructions run the reflected form of the same poly, so feed
+ * them bit reversed bytes and reverse the register on the way in and out.
+ */
+#if defined(__clang__)
+#define CRC32_TARGET_ARMV8 __attribute__((target("crc")))
+#else
+#define CRC32_TARGET_ARMV8 __attribute__((target("+crc")))
+#endif
+
+static inline uint32_t Reverse32(uint32_t value) {
+    return __rbit(value);
+}
+
+static inline uint64_t ReverseBitsInBytes64(uint64_t value) {
+    return __builtin_bswap64(__rbitll(value));
+}
+
+static inline uint8_t ReverseBits8(uint8_t value) {
+    return static_cast<uint8_t>(__rbit(value) >> 24);
+}
+
+CRC32_TARGET_ARMV8
+static uint32_t UpdateArmv8(uint32_t crc, const uint8_t* data, uint64_t len) {
+    uint32_t r = Reverse32(crc);
+    while (len >= 8) {
+        uint64_t value;
+        memcpy(&value, data, sizeof(value));
+        r = __crc32d(r, ReverseBitsInBytes64(value));
+        data += 8;
+        len -= 8;
+    }
+    while (len--) {
+        r = __crc32b(r, ReverseBits8(*data++));
+    }
+    return Reverse32(r);
+}
+
+static bool HasHardware() {
+#if defined(__linux__)
+    return getauxval(AT_HWCAP) & HWCAP_CRC32;
+#elif defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+#endif // CRC32_ENGINE_ARMV8
+
+typedef uint32_t (*Crc32Update)(uint32_t crc, const uint8_t* data, uint64_t len);
+
+struct Crc32Engine {
+    Crc32Update update;
+    const char* name;
+
+    Crc32Engine() : update(Crc32::UpdateSlicing8), name("slicing-by-8") {
+#if defined(CRC32_ENGINE_CLMUL)
+        if (HasHardware()) {
+            update = UpdateClmul;
+            name = "pclmulqdq";
+        }
+#elif defined(CRC32_ENGINE_ARMV8)
+        if (HasHardware()) {
+            update = UpdateArmv8;
+            name = "armv8-crc32";
+        }
+#endif
+    }
+};
+
+static const Crc32Engine& GetEngine() {
+    static Crc32Engine engine;
+    return engine;
+}
+
+uint32_t Crc32::Update(uint32_t crc, const uint8_t* data, uint64_t len) {
+    return GetEngine().update(crc, data, len);
+}
+
+const char* Crc32::Engine() {
+    return GetEngine().name;
+}
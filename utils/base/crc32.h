@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_CRC32_H_
+#define UTILS_BASE_CRC32_H_
+
+#include <stdint.h>
+
+/*
+ * MSB-first crc32, poly 0x04C11DB7, init 0xFFFFFFFF, no final xor.
+ *
+ *  Bitwise   1 bit per step, reference
+ *  Slicing8  8 bytes per step, 8 x 256 tables
+ *  Clmul     x86 pclmulqdq, fold 4 x 128 bits per step
+ *  Armv8     aarch64 crc32 instructions on bit reversed bytes
+ *
+ * Update picks the fastest engine the cpu supports on first use,
+ * every engine gives the same result.
+ */
+class Crc32 {
+public:
+    static constexpr uint32_t kPoly = 0x04C11DB7;
+    static constexpr uint32_t kInit = 0xFFFFFFFF;
+
+    static uint32_t Compute(const uint8_t* data, uint64_t len) { return Update(kInit, data, len); }
+    static uint32_t Update(uint32_t crc, const uint8_t* data, uint64_t len);
+    static const char* Engine();
+
+    static uint32_t UpdateBitwise(uint32_t crc, const uint8_t* data, uint64_t len);
+    static uint32_t UpdateSlicing8(uint32_t crc, const uint8_t* data, uint64_t len);
+};
+
+#endif // UTILS_BASE_CRC32_H_
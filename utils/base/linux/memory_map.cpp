@@ -92,6 +92,16 @@ MemoryMap* MemoryMap::MmapZeroMem(uint64_t size) {
     return map;
 }
 
+MemoryMap* MemoryMap::MmapSharedMem(uint64_t size) {
+    MemoryMap *map = nullptr;
+    // keep same address and contents on fork child
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+    if (mem != MAP_FAILED) {
+        map = new MemoryMap(mem, size, 0, size);
+    }
+    return map;
+}
+
 void MemoryMap::setFile(const char* file, uint64_t off) {
     if (file)
         mName = file;
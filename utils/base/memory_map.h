@@ -31,6 +31,7 @@ public:
     static MemoryMap* MmapMem(uint64_t addr, uint64_t size);
     static MemoryMap* MmapMem(uint64_t addr, uint64_t size, uint64_t realSize);
     static MemoryMap* MmapZeroMem(uint64_t size);
+    static MemoryMap* MmapSharedMem(uint64_t size);
     inline uint64_t data() { return reinterpret_cast<uint64_t>(mBegin); }
     inline uint64_t size() { return mSize; }
     inline uint64_t offset() { return mOffset; }
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger/log.h"
+#include "base/shared_cache.h"
+#include <string.h>
+#include <mutex>
+
+static constexpr uint64_t SHARED_CACHE_MAGIC = 0x45484341435250ULL; // "PRCACHE"
+
+std::unique_ptr<MemoryMap> SharedCache::INSTANCE;
+// parallel walkers may fill the cache from several threads.
+static std::mutex put_lock;
+
+static inline SharedCache::Header* GetHeader(MemoryMap* map) {
+    return reinterpret_cast<SharedCache::Header*>(map->data());
+}
+
+static inline SharedCache::Slot* GetSlots(MemoryMap* map) {
+    return reinterpret_cast<SharedCache::Slot*>(map->data() + sizeof(SharedCache::Header));
+}
+
+static inline uint64_t GetDataBegin() {
+    return sizeof(SharedCache::Header) + sizeof(SharedCache::Slot) * SharedCache::kSlotCount;
+}
+
+void SharedCache::Init(uint64_t size) {
+    if (INSTANCE)
+        return;
+
+    if (size <= GetDataBegin())
+        return;
+
+    INSTANCE.reset(MemoryMap::MmapSharedMem(size));
+    if (INSTANCE) Clean();
+}
+
+void SharedCache::Clean() {
+    if (!INSTANCE)
+        return;
+
+    Header* header = GetHeader(INSTANCE.get());
+    if (header->magic == SHARED_CACHE_MAGIC && !header->count)
+        return;
+
+    header->magic = SHARED_CACHE_MAGIC;
+    header->used = GetDataBegin();
+    header->count = 0;
+    memset(GetSlots(INSTANCE.get()), 0x0, sizeof(Slot) * kSlotCount);
+}
+
+SharedCache::Slot* SharedCache::FindSlot(uint32_t tag, uint64_t key) {
+    Slot* slots = GetSlots(INSTANCE.get());
+    uint64_t hash = (key ^ (static_cast<uint64_t>(tag) << 56)) * 0x9E3779B97F4A7C15ULL;
+    uint32_t index = (hash >> 32) & (kSlotCount - 1);
+    for (uint32_t i = 0; i < kSlotCount; ++i) {
+        Slot* slot = &slots[(index + i) & (kSlotCount - 1)];
+        uint64_t slot_key = __atomic_load_n(&slot->key, __ATOMIC_ACQUIRE);
+        if (!slot_key || (slot_key == key && slot->tag == tag))
+            return slot;
+    }
+    return nullptr;
+}
+
+const void* SharedCache::Get(uint32_t tag, uint64_t key, uint32_t* size) {
+    if (!INSTANCE || !key)
+        return nullptr;
+
+    Slot* slot = FindSlot(tag, key);
+    if (!slot || !__atomic_load_n(&slot->key, __ATOMIC_ACQUIRE))
+        return nullptr;
+
+    if (size) *size = slot->size;
+    return reinterpret_cast<const void*>(INSTANCE->data() + slot->offset);
+}
+
+bool SharedCache::Put(uint32_t tag, uint64_t key, const void* data, uint32_t size) {
+    if (!INSTANCE || !key)
+        return false;
+
+    std::lock_guard<std::mutex> guard(put_lock);
+    Header* header = GetHeader(INSTANCE.get());
+    // keep 1/4 slots free, probe length stay short
+    if (header->count >= kSlotCount - kSlotCount / 4)
+        return false;
+
+    uint64_t offset = (header->used + 7) & ~7ULL;
+    if (offset + size > INSTANCE->size())
+        return false;
+
+    Slot* slot = FindSlot(tag, key);
+    if (!slot || slot->key)
+        return false;
+
+    memcpy(reinterpret_cast<void*>(INSTANCE->data() + offset), data, size);
+    header->used = offset + size;
+    slot->tag = tag;
+    slot->size = size;
+    slot->offset = offset;
+    __atomic_store_n(&slot->key, key, __ATOMIC_RELEASE);
+    header->count++;
+    return true;
+}
+
+void SharedCache::Dump() {
+    if (!INSTANCE)
+        return;
+
+    Header* header = GetHeader(INSTANCE.get());
+    LOGI("  * SharedCache: " ANSI_COLOR_LIGHTMAGENTA "%" PRId64 ANSI_COLOR_RESET " entries, "
+         ANSI_COLOR_LIGHTMAGENTA "0x%" PRIx64 "/0x%" PRIx64 "\n" ANSI_COLOR_RESET,
+            header->count, header->used, INSTANCE->size());
+}
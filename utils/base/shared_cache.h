@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_SHARED_CACHE_H_
+#define UTILS_BASE_SHARED_CACHE_H_
+
+#include "base/memory_map.h"
+#include <stdint.h>
+#include <memory>
+
+/*
+ * Result cache mapped MAP_SHARED by the parent before any ONCHLD fork,
+ * so values a child computes are still there for the next command.
+ *
+ *  --------------------------------------------------
+ * | Header | Slot[0] ... Slot[kSlotCount - 1] | data |
+ *  --------------------------------------------------
+ *
+ * Only one child runs at a time, a slot key is written after its data
+ * so an interrupted child never leaves a half entry behind.
+ */
+class SharedCache {
+public:
+    static constexpr uint64_t kDefaultSize = 64 * 1024 * 1024;
+    static constexpr uint32_t kSlotCount = 256 * 1024;
+
+    // tags
+    static constexpr uint32_t CLASS_DESCRIPTOR = 1;
+    static constexpr uint32_t CLASS_INSTANCE_FIELDS = 2;
+
+    struct Header {
+        uint64_t magic;
+        uint64_t used;
+        uint64_t count;
+    };
+
+    struct Slot {
+        uint64_t key;
+        uint32_t tag;
+        uint32_t size;
+        uint64_t offset;
+    };
+
+    static void Init() { Init(kDefaultSize); }
+    static void Init(uint64_t size);
+    static bool IsReady() { return INSTANCE != nullptr; }
+    static void Clean();
+    static const void* Get(uint32_t tag, uint64_t key, uint32_t* size);
+    static bool Put(uint32_t tag, uint64_t key, const void* data, uint32_t size);
+    static void Dump();
+private:
+    static std::unique_ptr<MemoryMap> INSTANCE;
+    static Slot* FindSlot(uint32_t tag, uint64_t key);
+};
+
+#endif // UTILS_BASE_SHARED_CACHE_H_
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/thread_pool.h"
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <exception>
+
+int ThreadPool::THREADS = 0;
+
+int ThreadPool::GetThreads() {
+    if (THREADS <= 0) {
+        THREADS = std::thread::hardware_concurrency();
+        if (THREADS <= 0) THREADS = 1;
+    }
+    return THREADS;
+}
+
+void ThreadPool::SetThreads(int num) {
+    THREADS = num;
+}
+
+struct WorkRange {
+    std::mutex lock;
+    uint64_t begin;
+    uint64_t end;
+};
+
+static bool PopRange(WorkRange& range, uint64_t* index) {
+    std::lock_guard<std::mutex> guard(range.lock);
+    if (range.begin >= range.end)
+        return false;
+    *index = range.begin++;
+    return true;
+}
+
+static bool StealRange(std::vector<std::unique_ptr<WorkRange>>& ranges, int worker) {
+    int victim = -1;
+    uint64_t most = 0;
+    for (int i = 0; i < ranges.size(); ++i) {
+        if (i == worker) continue;
+        std::lock_guard<std::mutex> guard(ranges[i]->lock);
+        uint64_t left = ranges[i]->end - ranges[i]->begin;
+        if (ranges[i]->begin < ranges[i]->end && left > most) {
+            most = left;
+            victim = i;
+        }
+    }
+
+    if (victim < 0)
+        return false;
+
+    std::scoped_lock guard(ranges[victim]->lock, ranges[worker]->lock);
+    WorkRange& from = *ranges[victim];
+    if (from.begin >= from.end)
+        return true; // drained meanwhile, retry
+
+    uint64_t half = (from.end - from.begin + 1) / 2;
+    ranges[worker]->begin = from.end - half;
+    ranges[worker]->end = from.end;
+    from.end -= half;
+    return true;
+}
+
+void ThreadPool::ParallelFor(uint64_t count, std::function<void (uint64_t index, int worker)> fn) {
+    if (!count)
+        return;
+
+    int num = GetThreads();
+    if (num > count) num = count;
+    if (num <= 1) {
+        for (uint64_t i = 0; i < count; ++i)
+            fn(i, 0);
+        return;
+    }
+
+    std::vector<std::unique_ptr<WorkRange>> ranges;
+    for (int i = 0; i < num; ++i) {
+        std::unique_ptr<WorkRange> range = std::make_unique<WorkRange>();
+        range->begin = count * i / num;
+        range->end = count * (i + 1) / num;
+        ranges.push_back(std::move(range));
+    }
+
+    std::mutex error_lock;
+    std::exception_ptr error;
+    auto work = [&](int worker) {
+        try {
+            uint64_t index;
+            do {
+                while (PopRange(*ranges[worker], &index))
+                    fn(index, worker);
+            } while (StealRange(ranges, worker));
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error) error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num; ++i)
+        threads.emplace_back(work, i);
+    work(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
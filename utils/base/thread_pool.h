@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2024-present, Guanyou.Chen. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTILS_BASE_THREAD_POOL_H_
+#define UTILS_BASE_THREAD_POOL_H_
+
+#include <stdint.h>
+#include <functional>
+
+/*
+ * ParallelFor(count, fn)
+ *
+ *   worker 0: [0 ........ n/k)   <-- steal half --.
+ *   worker 1: [n/k ... 2n/k)                       |
+ *   ...                                            |
+ *   worker k: [..... n)  --------------------------'
+ *
+ * Each worker drains its own index range first and then steals the
+ * upper half of the largest range left, so uneven tasks (full vs free
+ * regions, big vs small libraries) still keep every worker busy.
+ * fn(index, worker) runs exactly once per index, worker < GetThreads().
+ */
+class ThreadPool {
+public:
+    static int GetThreads();
+    static void SetThreads(int num);
+    static void ParallelFor(uint64_t count, std::function<void (uint64_t index, int worker)> fn);
+private:
+    static int THREADS;
+};
+
+#endif // UTILS_BASE_THREAD_POOL_H_
@@ -15,6 +15,7 @@
  */
 
 #include "base/utils.h"
+#include "base/crc32.h"
 #include <stdio.h>
 #include <inttypes.h>
 #include <stdint.h>
@@ -48,20 +49,8 @@ std::string Utils::ToHex(uint64_t value) {
     return sb;
 }
 
-uint32_t Utils::CRC32(uint8_t* data, uint32_t len) {
-    uint32_t crc = 0xFFFFFFFF;
-    for (uint32_t k = 0; k < len; ++k) {
-        crc ^= (uint32_t)data[k] << 24;
-        for (int i = 0; i < 8; ++i) {
-            if (crc & (1 << 31)) {
-                crc = (crc << 1) ^ 0x04C11DB7;
-            } else {
-                crc <<= 1;
-            }
-            crc &= 0xFFFFFFFF;
-        }
-    }
-    return crc;
+uint32_t Utils::CRC32(uint8_t* data, uint64_t len) {
+    return Crc32::Compute(data, len);
 }
 
 uint64_t Utils::CRC64(uint8_t* data, uint64_t len) {
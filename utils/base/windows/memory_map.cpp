@@ -108,6 +108,11 @@ MemoryMap* MemoryMap::MmapZeroMem(uint64_t size) {
     return map;
 }
 
+MemoryMap* MemoryMap::MmapSharedMem(uint64_t size) {
+    // no fork child on windows
+    return MmapZeroMem(size);
+}
+
 void MemoryMap::setFile(const char* file, uint64_t off) {
     if (file)
         mName = file;
@@ -20,6 +20,30 @@
 
 Logger gLog(Logger::LEVEL_ERROR, Logger::LEVEL_NONE, true);
 Logger* Logger::INSTANCE = &gLog;
+static thread_local std::string* capture = nullptr;
+
+void Logger::Capture(std::string* out) {
+    capture = out;
+}
+
+static void Output(const char* format, va_list ap) {
+    if (!capture) {
+        vfprintf(stdout, format, ap);
+        return;
+    }
+
+    va_list copy;
+    va_copy(copy, ap);
+    int length = vsnprintf(nullptr, 0, format, copy);
+    va_end(copy);
+    if (length <= 0)
+        return;
+
+    size_t offset = capture->length();
+    capture->resize(offset + length + 1);
+    vsnprintf(capture->data() + offset, length + 1, format, ap);
+    capture->resize(offset + length);
+}
 
 static void FilterAnsiColor(std::string& __format__) {
 #ifdef ANSI_HIGH_LIGHT
@@ -60,7 +84,7 @@ void Logger::debug(uint32_t __lv, const char *__restrict __format, ...) {
         FilterAnsiColor(buffer);
         va_list ap;
         va_start(ap, __format);
-        vfprintf(stdout, buffer.c_str(), ap);
+        Output(buffer.c_str(), ap);
         va_end(ap);
     }
 }
@@ -71,7 +95,7 @@ void Logger::info(const char *__restrict __format, ...) {
     FilterAnsiColor(__format__);
     va_list ap;
     va_start(ap, __format);
-    vfprintf(stdout, __format__.c_str(), ap);
+    Output(__format__.c_str(), ap);
     va_end(ap);
 }
 
@@ -85,7 +109,7 @@ void Logger::warn(const char *__restrict __format, ...) {
         FilterAnsiColor(buffer);
         va_list ap;
         va_start(ap, __format);
-        vfprintf(stdout, buffer.c_str(), ap);
+        Output(buffer.c_str(), ap);
         va_end(ap);
     }
 }
@@ -100,7 +124,7 @@ void Logger::error(const char *__restrict __format, ...) {
         FilterAnsiColor(buffer);
         va_list ap;
         va_start(ap, __format);
-        vfprintf(stdout, buffer.c_str(), ap);
+        Output(buffer.c_str(), ap);
         va_end(ap);
     }
 }
@@ -115,7 +139,7 @@ void Logger::fatal(const char *__restrict __format, ...) {
         FilterAnsiColor(buffer);
         va_list ap;
         va_start(ap, __format);
-        vfprintf(stdout, buffer.c_str(), ap);
+        Output(buffer.c_str(), ap);
         va_end(ap);
     }
 }
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <inttypes.h>
 #include <sys/types.h>
+#include <string>
 
 #define ENTER() LOGI("\n");
 
@@ -138,6 +139,21 @@ public:
     Logger(int lv, int dv, bool light) :
         mLevel(lv), mDebug(dv), mHighLight(light) {}
 
+    /*
+     * Logs of the calling thread append to out instead of stdout until
+     * Capture(nullptr), so workers can buffer output for ordered printing.
+     */
+    static void Capture(std::string* out);
+
+    // Capture(out) for the scope, ended on return and on any exception.
+    class ScopedCapture {
+    public:
+        ScopedCapture(std::string* out) { Capture(out); }
+        ~ScopedCapture() { Capture(nullptr); }
+        ScopedCapture(const ScopedCapture&) = delete;
+        ScopedCapture& operator=(const ScopedCapture&) = delete;
+    };
+
     static void debug(uint32_t __lv, const char *__restrict __format, ...);
     static void info(const char *__restrict __format, ...);
     static void warn(const char *__restrict __format, ...);